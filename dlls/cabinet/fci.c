@@ -138,6 +138,22 @@ struct data_block
     cab_UWORD   uncompressed;
 };
 
+#define MSZIP_MAX_JOBS 32   /* number of full blocks compressed in parallel */
+
+struct mszip_job
+{
+    unsigned char data_in[CAB_BLOCKMAX];
+    unsigned char data_out[2 * CAB_BLOCKMAX];
+    cab_UWORD     compressed;  /* 0 on failure */
+};
+
+struct mszip_jobs
+{
+    struct mszip_job *job;
+    unsigned int      count;
+    LONG              next;
+};
+
 typedef struct FCI_Int
 {
   unsigned int       magic;
@@ -185,6 +201,8 @@ typedef struct FCI_Int
   cab_ULONG          folders_data_size;   /* total size of data contained in the current folders */
   TCOMP              compression;
   cab_UWORD        (*compress)(struct FCI_Int *);
+  struct mszip_job  *mszip_jobs;          /* full blocks waiting to be compressed in parallel */
+  unsigned int       mszip_job_count;
 } FCI_Int;
 
 #define FCI_INT_MAGIC 0xfcfcfc05
@@ -305,14 +323,13 @@ static void free_file( FCI_Int *fci, struct file *file )
     fci->free( file );
 }
 
-/* create a new data block for the data in fci->data_in */
-static BOOL add_data_block( FCI_Int *fci, PFNFCISTATUS status_callback )
+/* write an already compressed data block to the temp data file */
+static BOOL write_data_block( FCI_Int *fci, unsigned char *data, cab_UWORD compressed,
+                              cab_UWORD uncompressed, PFNFCISTATUS status_callback )
 {
     int err;
     struct data_block *block;
 
-    if (!fci->cdata_in) return TRUE;
-
     if (fci->data.handle == -1 && !create_temp_file( fci, &fci->data )) return FALSE;
 
     if (!(block = fci->alloc( sizeof(*block) )))
@@ -320,10 +337,10 @@ static BOOL add_data_block( FCI_Int *fci, PFNFCISTATUS status_callback )
         set_error( fci, FCIERR_ALLOC_FAIL, ERROR_NOT_ENOUGH_MEMORY );
         return FALSE;
     }
-    block->uncompressed = fci->cdata_in;
-    block->compressed   = fci->compress( fci );
+    block->uncompressed = uncompressed;
+    block->compressed   = compressed;
 
-    if (fci->write( fci->data.handle, fci->data_out,
+    if (fci->write( fci->data.handle, data,
                     block->compressed, &err, fci->pv ) != block->compressed)
     {
         set_error( fci, FCIERR_TEMP_FILE, err );
@@ -331,7 +348,6 @@ static BOOL add_data_block( FCI_Int *fci, PFNFCISTATUS status_callback )
         return FALSE;
     }
 
-    fci->cdata_in = 0;
     fci->pending_data_size += sizeof(CFDATA) + fci->ccab.cbReserveCFData + block->compressed;
     fci->cCompressedBytesInFolder += block->compressed;
     fci->cDataBlocks++;
@@ -345,6 +361,120 @@ static BOOL add_data_block( FCI_Int *fci, PFNFCISTATUS status_callback )
     return TRUE;
 }
 
+/* create a new data block for the data in fci->data_in */
+static BOOL add_data_block( FCI_Int *fci, PFNFCISTATUS status_callback )
+{
+    cab_UWORD compressed;
+
+    if (!fci->cdata_in) return TRUE;
+
+    compressed = fci->compress( fci );
+    if (!write_data_block( fci, fci->data_out, compressed, fci->cdata_in, status_callback ))
+        return FALSE;
+    fci->cdata_in = 0;
+    return TRUE;
+}
+
+static void *mszip_job_alloc( void *opaque, unsigned int items, unsigned int size )
+{
+    return malloc( (size_t)items * size );
+}
+
+static void mszip_job_free( void *opaque, void *ptr )
+{
+    free( ptr );
+}
+
+/* MSZIP blocks are deflated independently of each other, so full blocks can be
+ * compressed on worker threads and written out in order afterwards; the result
+ * is identical to compressing them one by one. The workers must not call the
+ * application's allocation callbacks, which need not be thread safe. */
+static void mszip_compress_jobs( struct mszip_jobs *jobs )
+{
+    struct mszip_job *job;
+    unsigned int i;
+    z_stream stream;
+
+    while ((i = InterlockedIncrement( &jobs->next ) - 1) < jobs->count)
+    {
+        job = &jobs->job[i];
+        job->compressed = 0;
+        stream.zalloc = mszip_job_alloc;
+        stream.zfree  = mszip_job_free;
+        stream.opaque = NULL;
+        if (deflateInit2( &stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY ) != Z_OK)
+            continue;
+        stream.next_in   = job->data_in;
+        stream.avail_in  = CAB_BLOCKMAX;
+        stream.next_out  = job->data_out + 2;
+        stream.avail_out = sizeof(job->data_out) - 2;
+        job->data_out[0] = 'C';
+        job->data_out[1] = 'K';
+        deflate( &stream, Z_FINISH );
+        deflateEnd( &stream );
+        job->compressed = stream.total_out + 2;
+    }
+}
+
+static void CALLBACK mszip_compress_cb( TP_CALLBACK_INSTANCE *instance, void *context, TP_WORK *work )
+{
+    mszip_compress_jobs( context );
+}
+
+/* compress the queued MSZIP blocks and add them to the folder in order */
+static BOOL flush_mszip_jobs( FCI_Int *fci, PFNFCISTATUS status_callback )
+{
+    struct mszip_jobs jobs;
+    unsigned int i, thread_count, count = fci->mszip_job_count;
+    TP_WORK *work;
+
+    if (!count) return TRUE;
+    fci->mszip_job_count = 0;
+
+    jobs.job   = fci->mszip_jobs;
+    jobs.count = count;
+    jobs.next  = 0;
+
+    thread_count = min( NtCurrentTeb()->Peb->NumberOfProcessors, count );
+    if (thread_count > 1 && (work = CreateThreadpoolWork( mszip_compress_cb, &jobs, NULL )))
+    {
+        TRACE( "compressing %u blocks on up to %u threads\n", count, thread_count );
+        for (i = 1; i < thread_count; i++) SubmitThreadpoolWork( work );
+        mszip_compress_jobs( &jobs );
+        WaitForThreadpoolWorkCallbacks( work, FALSE );
+        CloseThreadpoolWork( work );
+    }
+    else mszip_compress_jobs( &jobs );
+
+    for (i = 0; i < count; i++)
+    {
+        if (!jobs.job[i].compressed)
+        {
+            set_error( fci, FCIERR_ALLOC_FAIL, ERROR_NOT_ENOUGH_MEMORY );
+            return FALSE;
+        }
+        if (!write_data_block( fci, jobs.job[i].data_out, jobs.job[i].compressed,
+                               CAB_BLOCKMAX, status_callback ))
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/* queue the full block in fci->data_in for parallel compression, or compress it right away */
+static BOOL add_full_data_block( FCI_Int *fci, PFNFCISTATUS status_callback )
+{
+    if (fci->compression != tcompTYPE_MSZIP || NtCurrentTeb()->Peb->NumberOfProcessors < 2)
+        return add_data_block( fci, status_callback );
+
+    if (!fci->mszip_jobs && !(fci->mszip_jobs = malloc( MSZIP_MAX_JOBS * sizeof(*fci->mszip_jobs) )))
+        return add_data_block( fci, status_callback );
+
+    memcpy( fci->mszip_jobs[fci->mszip_job_count++].data_in, fci->data_in, CAB_BLOCKMAX );
+    fci->cdata_in = 0;
+    if (fci->mszip_job_count == MSZIP_MAX_JOBS) return flush_mszip_jobs( fci, status_callback );
+    return TRUE;
+}
+
 /* add compressed blocks for all the data that can be read from the file */
 static BOOL add_file_data( FCI_Int *fci, char *sourcefile, char *filename, BOOL execute,
                            PFNFCIGETOPENINFO get_open_info, PFNFCISTATUS status_callback )
@@ -372,15 +502,17 @@ static BOOL add_file_data( FCI_Int *fci, char *sourcefile, char *filename, BOOL
 
         if (len == -1)
         {
+            fci->mszip_job_count = 0;
             set_error( fci, FCIERR_READ_SRC, err );
             return FALSE;
         }
         file->size += len;
         fci->cdata_in += len;
-        if (fci->cdata_in == CAB_BLOCKMAX && !add_data_block( fci, status_callback )) return FALSE;
+        if (fci->cdata_in == CAB_BLOCKMAX && !add_full_data_block( fci, status_callback )) return FALSE;
     }
     fci->close( handle, &err, fci->pv );
-    return TRUE;
+    /* the size checks done by the caller rely on all full blocks having been added */
+    return flush_mszip_jobs( fci, status_callback );
 }
 
 static void free_data_block( FCI_Int *fci, struct data_block *block )
@@ -1723,6 +1855,7 @@ BOOL __cdecl FCIDestroy(HFCI hfci)
     }
 
     close_temp_file( p_fci_internal, &p_fci_internal->data );
+    free( p_fci_internal->mszip_jobs );
 
     /* hfci can now be removed */
     p_fci_internal->free(hfci);
@@ -708,40 +708,63 @@ struct host_object_params
     BOOL apartment_threaded; /* is the component purely apartment-threaded? */
 };
 
-/* Returns expanded dll path from the registry or activation context. */
-static BOOL get_object_dll_path(const struct class_reg_data *regdata, WCHAR *dst, DWORD dstlen)
+/* Reads the expanded dll path and threading model of an InprocServer32 or
+ * InprocHandler32 key. */
+void read_class_reg_data(HKEY hkey, struct class_reg_data *regdata)
 {
-    DWORD ret;
+    WCHAR *dst = regdata->u.registry.dll_path;
+    DWORD dstlen = ARRAY_SIZE(regdata->u.registry.dll_path);
+    WCHAR threading_model[10 /* lstrlenW(L"apartment")+1 */];
+    WCHAR src[MAX_PATH];
+    DWORD keytype, length, ret;
 
-    if (regdata->origin == CLASS_REG_REGISTRY)
-    {
-        DWORD keytype;
-        WCHAR src[MAX_PATH];
-        DWORD dwLength = dstlen * sizeof(WCHAR);
+    regdata->origin = CLASS_REG_REGISTRY;
 
-        if ((ret = RegQueryValueExW(regdata->u.hkey, NULL, NULL, &keytype, (BYTE*)src, &dwLength)) == ERROR_SUCCESS)
+    length = sizeof(src);
+    *dst = 0;
+    if ((ret = RegQueryValueExW(hkey, NULL, NULL, &keytype, (BYTE*)src, &length)) == ERROR_SUCCESS)
+    {
+        if (keytype == REG_EXPAND_SZ)
         {
-            if (keytype == REG_EXPAND_SZ)
-            {
-                if (dstlen <= ExpandEnvironmentStringsW(src, dst, dstlen)) ret = ERROR_MORE_DATA;
-            }
-            else
+            if (dstlen <= ExpandEnvironmentStringsW(src, dst, dstlen)) *dst = 0;
+        }
+        else
+        {
+            const WCHAR *quote_start;
+            quote_start = wcschr(src, '\"');
+            if (quote_start)
             {
-                const WCHAR *quote_start;
-                quote_start = wcschr(src, '\"');
-                if (quote_start)
+                const WCHAR *quote_end = wcschr(quote_start + 1, '\"');
+                if (quote_end)
                 {
-                    const WCHAR *quote_end = wcschr(quote_start + 1, '\"');
-                    if (quote_end)
-                    {
-                        memmove(src, quote_start + 1, (quote_end - quote_start - 1) * sizeof(WCHAR));
-                        src[quote_end - quote_start - 1] = '\0';
-                    }
+                    memmove(src, quote_start + 1, (quote_end - quote_start - 1) * sizeof(WCHAR));
+                    src[quote_end - quote_start - 1] = '\0';
                 }
-                lstrcpynW(dst, src, dstlen);
             }
+            lstrcpynW(dst, src, dstlen);
         }
-        return !ret;
+    }
+
+    length = sizeof(threading_model);
+    ret = RegQueryValueExW(hkey, L"ThreadingModel", NULL, &keytype, (BYTE*)threading_model, &length);
+    if ((ret != ERROR_SUCCESS) || (keytype != REG_SZ))
+        threading_model[0] = '\0';
+
+    if (!wcsicmp(threading_model, L"Apartment")) regdata->u.registry.threading_model = ThreadingModel_Apartment;
+    else if (!wcsicmp(threading_model, L"Free")) regdata->u.registry.threading_model = ThreadingModel_Free;
+    else if (!wcsicmp(threading_model, L"Both")) regdata->u.registry.threading_model = ThreadingModel_Both;
+    /* there's not specific handling for this case */
+    else if (threading_model[0]) regdata->u.registry.threading_model = ThreadingModel_Neutral;
+    else regdata->u.registry.threading_model = ThreadingModel_No;
+}
+
+/* Returns expanded dll path from the registry or activation context. */
+static BOOL get_object_dll_path(const struct class_reg_data *regdata, WCHAR *dst, DWORD dstlen)
+{
+    if (regdata->origin == CLASS_REG_REGISTRY)
+    {
+        lstrcpynW(dst, regdata->u.registry.dll_path, dstlen);
+        return *dst != 0;
     }
     else
     {
@@ -749,7 +772,7 @@ static BOOL get_object_dll_path(const struct class_reg_data *regdata, WCHAR *dst
 
         *dst = 0;
         ActivateActCtx(regdata->u.actctx.hactctx, &cookie);
-        ret = SearchPathW(NULL, regdata->u.actctx.module_name, L".dll", dstlen, dst, NULL);
+        SearchPathW(NULL, regdata->u.actctx.module_name, L".dll", dstlen, dst, NULL);
         DeactivateActCtx(0, cookie);
         return *dst != 0;
     }
@@ -1006,24 +1029,7 @@ static HRESULT apartment_hostobject_in_hostapt(struct apartment *apt, BOOL multi
 static enum comclass_threadingmodel get_threading_model(const struct class_reg_data *data)
 {
     if (data->origin == CLASS_REG_REGISTRY)
-    {
-        WCHAR threading_model[10 /* lstrlenW(L"apartment")+1 */];
-        DWORD dwLength = sizeof(threading_model);
-        DWORD keytype;
-        DWORD ret;
-
-        ret = RegQueryValueExW(data->u.hkey, L"ThreadingModel", NULL, &keytype, (BYTE*)threading_model, &dwLength);
-        if ((ret != ERROR_SUCCESS) || (keytype != REG_SZ))
-            threading_model[0] = '\0';
-
-        if (!wcsicmp(threading_model, L"Apartment")) return ThreadingModel_Apartment;
-        if (!wcsicmp(threading_model, L"Free")) return ThreadingModel_Free;
-        if (!wcsicmp(threading_model, L"Both")) return ThreadingModel_Both;
-
-        /* there's not specific handling for this case */
-        if (threading_model[0]) return ThreadingModel_Neutral;
-        return ThreadingModel_No;
-    }
+        return data->u.registry.threading_model;
     else
         return data->u.actctx.threading_model;
 }
@@ -332,6 +332,124 @@ HRESULT open_key_for_clsid(REFCLSID clsid, const WCHAR *keyname, REGSAM access,
     return S_OK;
 }
 
+struct inproc_class
+{
+    struct list entry;
+    CLSID clsid;
+    BOOL handler;
+    HRESULT hr;
+    struct class_reg_data regdata;
+};
+
+/* in-process server and handler registrations, most recently used first */
+static struct list inproc_classes = LIST_INIT(inproc_classes);
+static unsigned int inproc_class_count;
+static HKEY inproc_class_watch_key;
+static HANDLE inproc_class_watch_event;
+static BOOL inproc_class_watching;
+
+#define MAX_INPROC_CLASSES 256
+
+static CRITICAL_SECTION inproc_classes_cs;
+static CRITICAL_SECTION_DEBUG inproc_classes_cs_debug =
+{
+    0, 0, &inproc_classes_cs,
+    { &inproc_classes_cs_debug.ProcessLocksList, &inproc_classes_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": inproc_classes_cs") }
+};
+static CRITICAL_SECTION inproc_classes_cs = { &inproc_classes_cs_debug, -1, 0, 0, 0, 0 };
+
+static void free_inproc_classes(void)
+{
+    struct inproc_class *cur, *next;
+
+    LIST_FOR_EACH_ENTRY_SAFE(cur, next, &inproc_classes, struct inproc_class, entry)
+    {
+        list_remove(&cur->entry);
+        free(cur);
+    }
+    inproc_class_count = 0;
+}
+
+/* Returns whether cached registrations can be used. They are dropped
+ * whenever anything below HKCR changes. */
+static BOOL check_inproc_classes(void)
+{
+    if (inproc_class_watching && WaitForSingleObject(inproc_class_watch_event, 0) == WAIT_TIMEOUT)
+        return TRUE;
+
+    free_inproc_classes();
+    inproc_class_watching = FALSE;
+
+    if (!inproc_class_watch_event && !(inproc_class_watch_event = CreateEventW(NULL, FALSE, FALSE, NULL)))
+        return FALSE;
+    if (!inproc_class_watch_key && !(inproc_class_watch_key = create_classes_root_hkey(KEY_NOTIFY | KEY_WOW64_64KEY)))
+        return FALSE;
+    if (RegNotifyChangeKeyValue(inproc_class_watch_key, TRUE,
+            REG_NOTIFY_CHANGE_NAME | REG_NOTIFY_CHANGE_LAST_SET | REG_NOTIFY_THREAD_AGNOSTIC,
+            inproc_class_watch_event, TRUE))
+        return FALSE;
+
+    inproc_class_watching = TRUE;
+    return TRUE;
+}
+
+/* reads the InprocServer32 or InprocHandler32 registration of a class */
+static HRESULT get_inproc_class_reg_data(REFCLSID clsid, BOOL handler, struct class_reg_data *regdata)
+{
+    struct inproc_class *cur;
+    BOOL cache;
+    HRESULT hr;
+    HKEY hkey;
+
+    EnterCriticalSection(&inproc_classes_cs);
+
+    if ((cache = check_inproc_classes()))
+    {
+        LIST_FOR_EACH_ENTRY(cur, &inproc_classes, struct inproc_class, entry)
+        {
+            if (cur->handler == handler && IsEqualCLSID(&cur->clsid, clsid))
+            {
+                list_remove(&cur->entry);
+                list_add_head(&inproc_classes, &cur->entry);
+                *regdata = cur->regdata;
+                hr = cur->hr;
+                LeaveCriticalSection(&inproc_classes_cs);
+                return hr;
+            }
+        }
+    }
+
+    hr = open_key_for_clsid(clsid, handler ? L"InprocHandler32" : L"InprocServer32", KEY_READ, &hkey);
+    if (SUCCEEDED(hr))
+    {
+        read_class_reg_data(hkey, regdata);
+        RegCloseKey(hkey);
+    }
+
+    /* transient failures are not remembered */
+    if (cache && (SUCCEEDED(hr) || hr == REGDB_E_CLASSNOTREG || hr == REGDB_E_KEYMISSING) &&
+            (cur = malloc(sizeof(*cur))))
+    {
+        cur->clsid = *clsid;
+        cur->handler = handler;
+        cur->hr = hr;
+        if (SUCCEEDED(hr)) cur->regdata = *regdata;
+        list_add_head(&inproc_classes, &cur->entry);
+
+        if (++inproc_class_count > MAX_INPROC_CLASSES)
+        {
+            cur = LIST_ENTRY(list_tail(&inproc_classes), struct inproc_class, entry);
+            list_remove(&cur->entry);
+            free(cur);
+            inproc_class_count--;
+        }
+    }
+
+    LeaveCriticalSection(&inproc_classes_cs);
+    return hr;
+}
+
 /* open HKCR\\AppId\\{string form of appid clsid} key */
 HRESULT open_appidkey_from_clsid(REFCLSID clsid, REGSAM access, HKEY *subkey)
 {
@@ -1770,9 +1888,7 @@ static HRESULT com_get_class_object(REFCLSID rclsid, DWORD clscontext,
     /* First try in-process server */
     if (clscontext & CLSCTX_INPROC_SERVER)
     {
-        HKEY hkey;
-
-        hr = open_key_for_clsid(rclsid, L"InprocServer32", KEY_READ, &hkey);
+        hr = get_inproc_class_reg_data(rclsid, FALSE, &clsreg);
         if (FAILED(hr))
         {
             if (hr == REGDB_E_CLASSNOTREG)
@@ -1785,13 +1901,7 @@ static HRESULT com_get_class_object(REFCLSID rclsid, DWORD clscontext,
         }
 
         if (SUCCEEDED(hr))
-        {
-            clsreg.u.hkey = hkey;
-            clsreg.origin = CLASS_REG_REGISTRY;
-
             hr = apartment_get_inproc_class_object(apt, &clsreg, rclsid, riid, clscontext, obj);
-            RegCloseKey(hkey);
-        }
 
         /* return if we got a class, otherwise fall through to one of the
          * other types */
@@ -1805,9 +1915,7 @@ static HRESULT com_get_class_object(REFCLSID rclsid, DWORD clscontext,
     /* Next try in-process handler */
     if (clscontext & CLSCTX_INPROC_HANDLER)
     {
-        HKEY hkey;
-
-        hr = open_key_for_clsid(rclsid, L"InprocHandler32", KEY_READ, &hkey);
+        hr = get_inproc_class_reg_data(rclsid, TRUE, &clsreg);
         if (FAILED(hr))
         {
             if (hr == REGDB_E_CLASSNOTREG)
@@ -1820,13 +1928,7 @@ static HRESULT com_get_class_object(REFCLSID rclsid, DWORD clscontext,
         }
 
         if (SUCCEEDED(hr))
-        {
-            clsreg.u.hkey = hkey;
-            clsreg.origin = CLASS_REG_REGISTRY;
-
             hr = apartment_get_inproc_class_object(apt, &clsreg, rclsid, riid, clscontext, obj);
-            RegCloseKey(hkey);
-        }
 
         /* return if we got a class, otherwise fall through to one of the
          * other types */
@@ -152,10 +152,16 @@ struct class_reg_data
             DWORD threading_model;
             HANDLE hactctx;
         } actctx;
-        HKEY hkey;
+        struct
+        {
+            DWORD threading_model;
+            WCHAR dll_path[MAX_PATH + 1]; /* empty if the key has no usable path */
+        } registry;
     } u;
 };
 
+void read_class_reg_data(HKEY hkey, struct class_reg_data *regdata);
+
 HRESULT enter_apartment(struct tlsdata *data, DWORD model);
 void leave_apartment(struct tlsdata *data);
 void apartment_release(struct apartment *apt);
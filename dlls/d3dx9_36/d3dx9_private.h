@@ -416,6 +416,7 @@ struct d3dx_regstore
 };
 
 struct d3dx_pres_ins;
+struct d3dx_pres_exec_ins;
 
 struct d3dx_preshader
 {
@@ -423,6 +424,7 @@ struct d3dx_preshader
 
     unsigned int ins_count;
     struct d3dx_pres_ins *ins;
+    struct d3dx_pres_exec_ins *exec_ins;
 
     struct d3dx_const_tab inputs;
 };
@@ -258,6 +258,25 @@ struct d3dx_pres_ins
     struct d3dx_pres_operand output;
 };
 
+/* Instruction with its operands resolved to register storage, for operands
+ * which don't use relative addressing. */
+struct d3dx_pres_exec_arg
+{
+    const BYTE *ptr;
+    /* Distance between components in bytes, 0 for a replicated scalar. */
+    unsigned int stride;
+    BOOL is_double;
+};
+
+struct d3dx_pres_exec_ins
+{
+    BOOL direct;
+    struct d3dx_pres_exec_arg inputs[MAX_INPUTS_COUNT];
+    BYTE *output;
+    unsigned int output_stride;
+    enum pres_value_type output_type;
+};
+
 struct const_upload_info
 {
     BOOL transpose;
@@ -1229,6 +1248,63 @@ static HRESULT parse_preshader(struct d3dx_preshader *pres, unsigned int *ptr, u
     return D3D_OK;
 }
 
+static BOOL compile_pres_arg(struct d3dx_regstore *rs, const struct d3dx_pres_operand *opr,
+        BOOL scalar, struct d3dx_pres_exec_arg *arg)
+{
+    enum pres_reg_tables table = opr->reg.table;
+
+    if (opr->index_reg.table != PRES_REGTAB_COUNT)
+        return FALSE;
+    if (table_info[table].type != PRES_VT_FLOAT && table_info[table].type != PRES_VT_DOUBLE)
+        return FALSE;
+
+    /* Register bounds were validated by parse_preshader(). */
+    arg->ptr = (const BYTE *)rs->tables[table] + table_info[table].component_size * opr->reg.offset;
+    arg->stride = scalar ? 0 : table_info[table].component_size;
+    arg->is_double = table_info[table].type == PRES_VT_DOUBLE;
+    return TRUE;
+}
+
+/* The register tables don't move once allocated, so resolve instruction
+ * operands to memory once instead of on every preshader execution. */
+static HRESULT compile_preshader(struct d3dx_preshader *pres)
+{
+    unsigned int i, j, direct_count = 0;
+
+    if (!pres->ins_count)
+        return D3D_OK;
+
+    if (!(pres->exec_ins = calloc(pres->ins_count, sizeof(*pres->exec_ins))))
+        return E_OUTOFMEMORY;
+
+    for (i = 0; i < pres->ins_count; ++i)
+    {
+        const struct d3dx_pres_ins *ins = &pres->ins[i];
+        struct d3dx_pres_exec_ins *exec_ins = &pres->exec_ins[i];
+        enum pres_reg_tables table = ins->output.reg.table;
+
+        exec_ins->direct = TRUE;
+        for (j = 0; j < pres_op_info[ins->op].input_count; ++j)
+        {
+            if (!compile_pres_arg(&pres->regs, &ins->inputs[j], ins->scalar_op && !j, &exec_ins->inputs[j]))
+            {
+                exec_ins->direct = FALSE;
+                break;
+            }
+        }
+        if (!exec_ins->direct)
+            continue;
+
+        exec_ins->output = (BYTE *)pres->regs.tables[table] + table_info[table].component_size * ins->output.reg.offset;
+        exec_ins->output_stride = table_info[table].component_size;
+        exec_ins->output_type = table_info[table].type;
+        ++direct_count;
+    }
+
+    TRACE("%u of %u instructions use direct register access.\n", direct_count, pres->ins_count);
+    return D3D_OK;
+}
+
 HRESULT d3dx_create_param_eval(struct d3dx_parameters_store *parameters, void *byte_code, unsigned int byte_code_size,
         D3DXPARAMETER_TYPE type, struct d3dx_param_eval **peval_out, ULONG64 *version_counter,
         const char **skip_constants, unsigned int skip_constants_count)
@@ -1315,6 +1391,9 @@ HRESULT d3dx_create_param_eval(struct d3dx_parameters_store *parameters, void *b
             goto err_out;
     }
 
+    if (FAILED(ret = compile_preshader(&peval->pres)))
+        goto err_out;
+
     if (TRACE_ON(d3dx))
     {
         dump_bytecode(byte_code, byte_code_size);
@@ -1348,6 +1427,7 @@ static void d3dx_free_const_tab(struct d3dx_const_tab *ctab)
 
 static void d3dx_free_preshader(struct d3dx_preshader *pres)
 {
+    free(pres->exec_ins);
     free(pres->ins);
 
     regstore_free_tables(&pres->regs);
@@ -1654,7 +1734,79 @@ static void exec_set_arg(struct d3dx_regstore *rs, const struct d3dx_pres_reg *r
     regstore_set_double(rs, reg->table, reg->offset + comp, res);
 }
 
+static inline double exec_load(const struct d3dx_pres_exec_arg *arg, unsigned int comp)
+{
+    const BYTE *p = arg->ptr + arg->stride * comp;
+
+    return arg->is_double ? *(const double *)p : *(const float *)p;
+}
+
+static inline void exec_store(const struct d3dx_pres_exec_ins *ins, unsigned int comp, double v)
+{
+    BYTE *p = ins->output + ins->output_stride * comp;
+
+    switch (ins->output_type)
+    {
+        case PRES_VT_FLOAT : *(float *)p = v; break;
+        case PRES_VT_DOUBLE: *(double *)p = v; break;
+        case PRES_VT_INT   : *(int *)p = lrint(v); break;
+        case PRES_VT_BOOL  : *(BOOL *)p = !!v; break;
+        default:
+            FIXME("Bad type %u.\n", ins->output_type);
+            break;
+    }
+}
+
 #define ARGS_ARRAY_SIZE 8
+/* Components are processed one at a time, reading all the inputs for a
+ * component before writing its result, since the output register may alias
+ * the inputs. */
+static void execute_direct_ins(const struct d3dx_pres_ins *ins, const struct d3dx_pres_exec_ins *exec_ins)
+{
+    const struct op_info *oi = &pres_op_info[ins->op];
+    double args[ARGS_ARRAY_SIZE];
+    unsigned int j, k;
+
+    switch (ins->op)
+    {
+        case PRESHADER_OP_MOV:
+            for (j = 0; j < ins->component_count; ++j)
+                exec_store(exec_ins, j, exec_load(&exec_ins->inputs[0], j));
+            break;
+
+        case PRESHADER_OP_NEG:
+            for (j = 0; j < ins->component_count; ++j)
+                exec_store(exec_ins, j, -exec_load(&exec_ins->inputs[0], j));
+            break;
+
+        case PRESHADER_OP_ADD:
+            for (j = 0; j < ins->component_count; ++j)
+                exec_store(exec_ins, j, exec_load(&exec_ins->inputs[0], j) + exec_load(&exec_ins->inputs[1], j));
+            break;
+
+        case PRESHADER_OP_MUL:
+            for (j = 0; j < ins->component_count; ++j)
+                exec_store(exec_ins, j, exec_load(&exec_ins->inputs[0], j) * exec_load(&exec_ins->inputs[1], j));
+            break;
+
+        case PRESHADER_OP_DOT:
+            for (k = 0; k < oi->input_count; ++k)
+                for (j = 0; j < ins->component_count; ++j)
+                    args[k * ins->component_count + j] = exec_load(&exec_ins->inputs[k], j);
+            exec_store(exec_ins, 0, pres_dot(args, ins->component_count));
+            break;
+
+        default:
+            for (j = 0; j < ins->component_count; ++j)
+            {
+                for (k = 0; k < oi->input_count; ++k)
+                    args[k] = exec_load(&exec_ins->inputs[k], j);
+                exec_store(exec_ins, j, oi->func(args, ins->component_count));
+            }
+            break;
+    }
+}
+
 static HRESULT execute_preshader(struct d3dx_preshader *pres)
 {
     unsigned int i, j, k;
@@ -1675,6 +1827,14 @@ static HRESULT execute_preshader(struct d3dx_preshader *pres)
                 FIXME("Too many arguments (%u) for one instruction.\n", oi->input_count * ins->component_count);
                 return E_FAIL;
             }
+        }
+        if (pres->exec_ins && pres->exec_ins[i].direct)
+        {
+            execute_direct_ins(ins, &pres->exec_ins[i]);
+            continue;
+        }
+        if (oi->func_all_comps)
+        {
             for (k = 0; k < oi->input_count; ++k)
                 for (j = 0; j < ins->component_count; ++j)
                     args[k * ins->component_count + j] = exec_get_arg(&pres->regs, &ins->inputs[k],
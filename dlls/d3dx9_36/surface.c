@@ -2316,6 +2316,74 @@ HRESULT d3dx_pixels_init(const void *data, uint32_t row_pitch, uint32_t slice_pi
     return S_OK;
 }
 
+/* Height in pixels of the horizontal bands a DXTn slice is split into for
+ * compression on multiple threads. */
+#define DXTN_BAND_HEIGHT 64
+
+struct dxtn_compress_job
+{
+    const BYTE *src;
+    BYTE *dst;
+    uint32_t width, height;
+    uint32_t dst_row_pitch;
+    GLenum format;
+    unsigned int band_count;
+    LONG next_band;
+};
+
+static void dxtn_compress_bands(struct dxtn_compress_job *job)
+{
+    unsigned int band;
+    uint32_t y;
+
+    while ((band = InterlockedIncrement(&job->next_band) - 1) < job->band_count)
+    {
+        y = band * DXTN_BAND_HEIGHT;
+        tx_compress_dxtn(4, job->width, min(DXTN_BAND_HEIGHT, job->height - y), job->src + y * job->width * 4,
+                job->format, job->dst + (y / 4) * job->dst_row_pitch, job->dst_row_pitch);
+    }
+}
+
+static void CALLBACK dxtn_compress_cb(TP_CALLBACK_INSTANCE *instance, void *context, TP_WORK *work)
+{
+    dxtn_compress_bands(context);
+}
+
+/* Blocks are encoded independently of each other, so bands of block rows
+ * can be compressed in parallel. */
+static void compress_dxtn_slice(const BYTE *src, uint32_t width, uint32_t height, GLenum format,
+        BYTE *dst, uint32_t dst_row_pitch)
+{
+    struct dxtn_compress_job job;
+    unsigned int i, thread_count;
+    SYSTEM_INFO info;
+    TP_WORK *work;
+
+    job.src = src;
+    job.dst = dst;
+    job.width = width;
+    job.height = height;
+    job.dst_row_pitch = dst_row_pitch;
+    job.format = format;
+    job.band_count = (height + DXTN_BAND_HEIGHT - 1) / DXTN_BAND_HEIGHT;
+    job.next_band = 0;
+
+    GetSystemInfo(&info);
+    thread_count = min(info.dwNumberOfProcessors, job.band_count);
+    if (thread_count < 2 || !(work = CreateThreadpoolWork(dxtn_compress_cb, &job, NULL)))
+    {
+        tx_compress_dxtn(4, width, height, src, format, dst, dst_row_pitch);
+        return;
+    }
+
+    TRACE("Compressing %u bands on up to %u threads.\n", job.band_count, thread_count);
+    for (i = 1; i < thread_count; ++i)
+        SubmitThreadpoolWork(work);
+    dxtn_compress_bands(&job);
+    WaitForThreadpoolWorkCallbacks(work, FALSE);
+    CloseThreadpoolWork(work);
+}
+
 static const char *debug_d3dx_pixels(struct d3dx_pixels *pixels)
 {
     if (!pixels)
@@ -2449,7 +2517,7 @@ HRESULT d3dx_load_pixels_from_pixels(struct d3dx_pixels *dst_pixels,
                 BYTE *uncompressed_mem_slice = (BYTE *)uncompressed_mem + (i * uncompressed_slice_pitch);
                 BYTE *dst_memory_slice = ((BYTE *)dst_pixels->data) + (i * dst_pixels->slice_pitch);
 
-                tx_compress_dxtn(4, dst_size_aligned.width, dst_size_aligned.height, uncompressed_mem_slice, gl_format,
+                compress_dxtn_slice(uncompressed_mem_slice, dst_size_aligned.width, dst_size_aligned.height, gl_format,
                         dst_memory_slice, dst_pixels->row_pitch);
             }
         }
@@ -328,6 +328,32 @@ void mixieee32(float *src, float *dst, unsigned samples)
         *(dst++) += *(src++);
 }
 
+void mixieee32_vol(const float *src, float *dst, unsigned frames, unsigned channels, const float *vols)
+{
+    unsigned i, chan;
+
+    TRACE("%p - %p %u %u\n", src, dst, frames, channels);
+
+    if (channels == 2)
+    {
+        /* Keep the common case free of the inner loop so that it vectorizes. */
+        for (i = 0; i < frames * 2; i += 2)
+        {
+            dst[i] += src[i] * vols[0];
+            dst[i + 1] += src[i + 1] * vols[1];
+        }
+        return;
+    }
+
+    for (i = 0; i < frames; ++i)
+    {
+        for (chan = 0; chan < channels; ++chan)
+            dst[chan] += src[chan] * vols[chan];
+        src += channels;
+        dst += channels;
+    }
+}
+
 static void norm8(float *src, unsigned char *dst, unsigned samples)
 {
     TRACE("%p - %p %d\n", src, dst, samples);
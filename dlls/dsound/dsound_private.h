@@ -49,6 +49,7 @@ extern const bitsgetfunc getbpp[5];
 void putieee32(const IDirectSoundBufferImpl *dsb, DWORD pos, DWORD channel, float value);
 void putieee32_sum(const IDirectSoundBufferImpl *dsb, DWORD pos, DWORD channel, float value);
 void mixieee32(float *src, float *dst, unsigned samples);
+void mixieee32_vol(const float *src, float *dst, unsigned frames, unsigned channels, const float *vols);
 typedef void (*normfunc)(const void *, void *, unsigned);
 extern const normfunc normfunctions[4];
 
@@ -286,6 +286,26 @@ static inline float get_current_sample(const IDirectSoundBufferImpl *dsb,
     return dsb->get(dsb, buffer + (mixpos % buflen), channel);
 }
 
+/* Equivalent to calling get_current_sample() for count consecutive frames,
+ * without a division per sample. */
+static void get_current_samples(const IDirectSoundBufferImpl *dsb, BYTE *buffer, DWORD buflen,
+        DWORD mixpos, DWORD channel, float *out, UINT count)
+{
+    UINT istride = dsb->pwfx->nBlockAlign;
+    UINT i;
+
+    for (i = 0; i < count; i++, mixpos += istride) {
+        if (mixpos >= buflen) {
+            if (!(dsb->playflags & DSBPLAY_LOOPING)) {
+                memset(out + i, 0, (count - i) * sizeof(*out));
+                return;
+            }
+            mixpos %= buflen;
+        }
+        out[i] = dsb->get(dsb, buffer + mixpos, channel);
+    }
+}
+
 static UINT cp_fields_noresample(IDirectSoundBufferImpl *dsb, UINT count)
 {
     UINT istride = dsb->pwfx->nBlockAlign;
@@ -362,12 +382,12 @@ static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, UINT count, LONG64 *
      */
     itmp = intermediate;
     for (channel = 0; channel < channels; channel++) {
-        for (i = 0; i < committed_samples; i++)
-            *(itmp++) = get_current_sample(dsb, dsb->committedbuff,
-                dsb->writelead, dsb->committed_mixpos + i * istride, channel);
-        for (; i < required_input; i++)
-            *(itmp++) = get_current_sample(dsb, dsb->buffer->memory,
-                    dsb->buflen, dsb->sec_mixpos + i * istride, channel);
+        get_current_samples(dsb, dsb->committedbuff, dsb->writelead,
+                dsb->committed_mixpos, channel, itmp, committed_samples);
+        get_current_samples(dsb, dsb->buffer->memory, dsb->buflen,
+                dsb->sec_mixpos + committed_samples * istride, channel,
+                itmp + committed_samples, required_input - committed_samples);
+        itmp += required_input;
     }
 
     for(i = 0; i < count; ++i) {
@@ -389,11 +409,19 @@ static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, UINT count, LONG64 *
 
         for (channel = 0; channel < dsb->mix_channels; channel++) {
             int j;
-            float sum = 0.0;
+            float sum[4] = {0.0f};
             float* cache = &intermediate[channel * required_input + ipos];
-            for (j = 0; j < fir_used; j++)
-                sum += fir_copy[j] * cache[j];
-            dsb->put(dsb, i * ostride, channel, sum * dsb->firgain);
+            /* Use independent partial sums, so that the compiler can keep
+             * them in one vector register. */
+            for (j = 0; j + 4 <= fir_used; j += 4) {
+                sum[0] += fir_copy[j] * cache[j];
+                sum[1] += fir_copy[j + 1] * cache[j + 1];
+                sum[2] += fir_copy[j + 2] * cache[j + 2];
+                sum[3] += fir_copy[j + 3] * cache[j + 3];
+            }
+            for (; j < fir_used; j++)
+                sum[0] += fir_copy[j] * cache[j];
+            dsb->put(dsb, i * ostride, channel, ((sum[0] + sum[1]) + (sum[2] + sum[3])) * dsb->firgain);
         }
     }
 
@@ -485,35 +513,30 @@ static void DSOUND_MixToTemporary(IDirectSoundBufferImpl *dsb, DWORD frames)
 	}
 }
 
-static void DSOUND_MixerVol(const IDirectSoundBufferImpl *dsb, INT frames)
+/* Returns FALSE if no volume needs to be applied. */
+static BOOL DSOUND_MixerVol(const IDirectSoundBufferImpl *dsb, float *vols)
 {
-	INT	i;
-	float vols[DS_MAX_CHANNELS];
-	UINT channels = dsb->device->pwfx->nChannels, chan;
+	UINT channels = dsb->device->pwfx->nChannels, i;
 
-	TRACE("(%p,%d)\n",dsb,frames);
+	TRACE("(%p)\n",dsb);
 	TRACE("left = %lx, right = %lx\n", dsb->volpan.dwTotalAmpFactor[0],
 		dsb->volpan.dwTotalAmpFactor[1]);
 
 	if ((!(dsb->dsbd.dwFlags & DSBCAPS_CTRLPAN) || (dsb->volpan.lPan == 0)) &&
 	    (!(dsb->dsbd.dwFlags & DSBCAPS_CTRLVOLUME) || (dsb->volpan.lVolume == 0)) &&
 	     !(dsb->dsbd.dwFlags & DSBCAPS_CTRL3D))
-		return; /* Nothing to do */
+		return FALSE; /* Nothing to do */
 
 	if (channels > DS_MAX_CHANNELS)
 	{
 		FIXME("There is no support for %u channels\n", channels);
-		return;
+		return FALSE;
 	}
 
 	for (i = 0; i < channels; ++i)
 		vols[i] = dsb->volpan.dwTotalAmpFactor[i] / ((float)0xFFFF);
 
-	for(i = 0; i < frames; ++i){
-		for(chan = 0; chan < channels; ++chan){
-			dsb->device->tmp_buffer[i * channels + chan] *= vols[chan];
-		}
-	}
+	return TRUE;
 }
 
 /**
@@ -542,10 +565,14 @@ static DWORD DSOUND_MixInBuffer(IDirectSoundBufferImpl *dsb, float *mix_buffer,
 	ibuf = dsb->device->tmp_buffer;
 
 	if (secondarybuffer_is_audible(dsb)) {
-		/* Apply volume if needed */
-		DSOUND_MixerVol(dsb, frames);
-
-		mixieee32(ibuf, mix_buffer, frames * dsb->device->pwfx->nChannels);
+		UINT channels = dsb->device->pwfx->nChannels;
+		float vols[DS_MAX_CHANNELS];
+
+		/* Apply volume if needed, in the same pass as the mixing */
+		if (DSOUND_MixerVol(dsb, vols))
+			mixieee32_vol(ibuf, mix_buffer, frames, channels, vols);
+		else
+			mixieee32(ibuf, mix_buffer, frames * channels);
 	}
 
 	/* check for notification positions */
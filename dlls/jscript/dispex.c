@@ -2538,6 +2538,55 @@ HRESULT jsdisp_get_id(jsdisp_t *jsdisp, const WCHAR *name, DWORD flags, DISPID *
     return DISP_E_UNKNOWNNAME;
 }
 
+/*
+ * Resolves a property slot remembered by a previous lookup of the same name. The slot is
+ * only trusted if it still resolves, through its PROTREF chain, to a property that the
+ * full lookup would return without consulting the prototype or the external lookup again.
+ * Slots are never reused for a different name, so a stale hint just misses.
+ */
+static dispex_prop_t *get_hinted_prop(jsdisp_t *jsdisp, unsigned idx, const WCHAR *name)
+{
+    dispex_prop_t *prop;
+
+    if(idx >= jsdisp->prop_cnt || jsdisp->builtin_info->lookup_prop)
+        return NULL;
+
+    prop = &jsdisp->props[idx];
+    if(wcscmp(prop->name, name))
+        return NULL;
+
+    while(jsdisp->props[idx].type == PROP_PROTREF) {
+        idx = jsdisp->props[idx].u.ref;
+        if(!(jsdisp = jsdisp->prototype) || idx >= jsdisp->prop_cnt)
+            return NULL;
+    }
+
+    switch(jsdisp->props[idx].type) {
+    case PROP_JSVAL:
+    case PROP_BUILTIN:
+    case PROP_ACCESSOR:
+        return prop;
+    default:
+        return NULL;
+    }
+}
+
+HRESULT jsdisp_get_id_hint(jsdisp_t *jsdisp, const WCHAR *name, DWORD flags, unsigned *hint, DISPID *id)
+{
+    dispex_prop_t *prop;
+    HRESULT hres;
+
+    if(!(flags & fdexNameCaseInsensitive) && (prop = get_hinted_prop(jsdisp, *hint, name))) {
+        *id = prop_to_id(jsdisp, prop);
+        return S_OK;
+    }
+
+    hres = jsdisp_get_id(jsdisp, name, flags, id);
+    if(SUCCEEDED(hres))
+        *hint = *id - 1;
+    return hres;
+}
+
 HRESULT jsdisp_get_idx_id(jsdisp_t *jsdisp, DWORD idx, DISPID *id)
 {
     WCHAR name[11];
@@ -587,7 +587,8 @@ static void scope_pop(scope_chain_t **scope)
     scope_release(tmp);
 }
 
-static HRESULT disp_get_id(script_ctx_t *ctx, IDispatch *disp, const WCHAR *name, BSTR name_bstr, DWORD flags, DISPID *id)
+static HRESULT disp_get_id_hint(script_ctx_t *ctx, IDispatch *disp, const WCHAR *name, BSTR name_bstr, DWORD flags,
+                                unsigned *hint, DISPID *id)
 {
     IDispatchEx *dispex;
     jsdisp_t *jsdisp;
@@ -596,7 +597,7 @@ static HRESULT disp_get_id(script_ctx_t *ctx, IDispatch *disp, const WCHAR *name
 
     jsdisp = to_jsdisp(disp);
     if(jsdisp)
-        return jsdisp_get_id(jsdisp, name, flags, id);
+        return hint ? jsdisp_get_id_hint(jsdisp, name, flags, hint, id) : jsdisp_get_id(jsdisp, name, flags, id);
 
     if(name_bstr) {
         bstr = name_bstr;
@@ -621,6 +622,11 @@ static HRESULT disp_get_id(script_ctx_t *ctx, IDispatch *disp, const WCHAR *name
     return hres;
 }
 
+static inline HRESULT disp_get_id(script_ctx_t *ctx, IDispatch *disp, const WCHAR *name, BSTR name_bstr, DWORD flags, DISPID *id)
+{
+    return disp_get_id_hint(ctx, disp, name, name_bstr, flags, NULL, id);
+}
+
 static HRESULT disp_cmp(IDispatch *disp1, IDispatch *disp2, BOOL *ret)
 {
     IObjectIdentity *identity;
@@ -974,6 +980,13 @@ static inline jsstr_t *get_op_str(script_ctx_t *ctx, int i)
     return frame->bytecode->instrs[frame->ip].u.arg[i].str;
 }
 
+/* The second argument of member access instructions is unused and caches the last resolved property slot. */
+static inline unsigned *get_op_prop_hint(script_ctx_t *ctx)
+{
+    call_frame_t *frame = ctx->call_ctx;
+    return &frame->bytecode->instrs[frame->ip].u.arg[1].uint;
+}
+
 static inline double get_op_double(script_ctx_t *ctx)
 {
     call_frame_t *frame = ctx->call_ctx;
@@ -1443,7 +1456,7 @@ static HRESULT interp_member(script_ctx_t *ctx)
     if(FAILED(hres))
         return hres;
 
-    hres = disp_get_id(ctx, obj, arg, arg, 0, &id);
+    hres = disp_get_id_hint(ctx, obj, arg, arg, 0, get_op_prop_hint(ctx), &id);
     if(SUCCEEDED(hres)) {
         hres = disp_propget(ctx, obj, id, &v);
     }else if(hres == DISP_E_UNKNOWNNAME) {
@@ -1485,7 +1498,7 @@ static HRESULT interp_memberid(script_ctx_t *ctx)
     if(FAILED(hres))
         return hres;
 
-    hres = disp_get_id(ctx, obj, name, NULL, arg, &id);
+    hres = disp_get_id_hint(ctx, obj, name, NULL, arg, get_op_prop_hint(ctx), &id);
     jsstr_release(name_str);
     if(SUCCEEDED(hres)) {
         ref.type = EXPRVAL_IDREF;
@@ -58,6 +58,9 @@ typedef struct regexp_t {
     struct RECharSet    *classList;    /* list of [...] bitmaps */
     const WCHAR         *source;       /* locked source string, sans // */
     DWORD               source_len;
+    WORD                first_kind;    /* how a match can start, see regexp.c */
+    WCHAR               first_chars[2]; /* possible first characters */
+    size_t              first_class;   /* class index the first character is in */
     jsbytecode          program[1];    /* regular expression bytecode */
 } regexp_t;
 
@@ -2162,3 +2162,41 @@ function test_es5_keywords() {
     ok(tmp === true, "Expected exception for 'const c1 = 1;'");
 }
 test_es5_keywords();
+
+function test_member_access_site() {
+    function get_x(o) { return o.x; }
+    function set_x(o, v) { o.x = v; }
+    function C() {}
+    var a = {x: 1}, b = {y: 0, x: 2}, c, d, i;
+
+    for(i = 0; i < 3; i++) {
+        ok(get_x(a) === 1, "get_x(a) = " + get_x(a));
+        ok(get_x(b) === 2, "get_x(b) = " + get_x(b));
+    }
+
+    C.prototype.x = 3;
+    c = new C();
+    d = new C();
+    ok(get_x(c) === 3, "get_x(c) = " + get_x(c));
+    ok(get_x(d) === 3, "get_x(d) = " + get_x(d));
+
+    C.prototype.x = 4;
+    ok(get_x(c) === 4, "get_x(c) = " + get_x(c) + " after prototype change");
+
+    set_x(c, 5);
+    ok(get_x(c) === 5, "get_x(c) = " + get_x(c) + " after own assignment");
+    ok(get_x(d) === 4, "get_x(d) = " + get_x(d) + " after assignment to c");
+
+    delete c.x;
+    ok(get_x(c) === 4, "get_x(c) = " + get_x(c) + " after delete");
+
+    delete C.prototype.x;
+    ok(get_x(c) === undefined, "get_x(c) = " + get_x(c) + " after prototype delete");
+    ok(get_x(d) === undefined, "get_x(d) = " + get_x(d) + " after prototype delete");
+
+    delete a.x;
+    ok(get_x(a) === undefined, "get_x(a) = " + get_x(a) + " after delete");
+    set_x(a, 6);
+    ok(get_x(a) === 6, "get_x(a) = " + get_x(a) + " after re-adding");
+}
+test_member_access_site();
@@ -732,4 +732,30 @@ ok(re.ignoreCase === false, "re.ignoreCase = " + re.ignoreCase);
 ok(re.multiline === true, "re.multiline = " + re.multiline);
 ok(re.global === true, "re.global = " + re.global);
 
+re = /(\d+)-([a-z]+)/;
+m = re.exec("x 12 34-ab");
+ok(m.index === 5, "m.index = " + m.index);
+ok(m[1] === "34", "m[1] = " + m[1]);
+ok(m[2] === "ab", "m[2] = " + m[2]);
+
+m = /b|c/.exec("aaac");
+ok(m.index === 3, "m.index = " + m.index);
+ok(/x|y/.exec("aaa") === null, "/x|y/ matched");
+
+m = /^b/.exec("a\nb");
+ok(m === null, "/^b/ matched");
+m = /^b/m.exec("a\nb");
+ok(m.index === 2, "m.index = " + m.index);
+m = /^$/m.exec("a\n");
+ok(m.index === 2, "m.index = " + m.index);
+
+m = "a.b.c".replace(/\./g, "-");
+ok(m === "a-b-c", "replace result = " + m);
+m = "foobar".split("ob");
+ok(m.length === 2 && m[1] === "ar", "split result = " + m);
+
+re = /\u1234/g;
+ok(re.test("abc\u1234") === true, "re.test returned false");
+ok(re.lastIndex === 4, "re.lastIndex = " + re.lastIndex);
+
 reportSuccess();
@@ -226,7 +226,7 @@ typedef struct _column_info
     struct _column_info *next;
 } column_info;
 
-typedef const struct tagMSICOLUMNHASHENTRY *MSIITERHANDLE;
+typedef const struct column_hash_entry *MSIITERHANDLE;
 
 typedef struct tagMSIVIEWOPS
 {
@@ -347,6 +347,18 @@ typedef struct tagMSIVIEWOPS
      * drop - drops the table from the database
      */
     UINT (*drop)( struct tagMSIVIEW *view );
+
+    /*
+     * find_matching_rows - iterates through rows that match a value
+     *
+     *  The value is compared against the raw value returned by fetch_int,
+     *   i.e. a string ID for string columns.
+     *  The handle is an input/output parameter that keeps track of the current
+     *   position in the iteration. It must be initialised to zero before the
+     *   first call and continued to be passed in to subsequent calls.
+     *  Returns ERROR_NO_MORE_ITEMS when there are no more matching rows.
+     */
+    UINT (*find_matching_rows)( struct tagMSIVIEW *view, UINT col, UINT val, UINT *row, MSIITERHANDLE *handle );
 } MSIVIEWOPS;
 
 struct tagMSIVIEW
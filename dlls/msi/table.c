@@ -55,6 +55,7 @@ struct column_info
     UINT    type;
     UINT    offset;
     struct column_hash_entry **hash_table;
+    UINT    hash_size;
 };
 
 struct tagMSITABLE
@@ -1472,6 +1473,17 @@ static UINT TABLE_set_row( struct tagMSIVIEW *view, UINT row, MSIRECORD *rec, UI
     return r;
 }
 
+static void reset_hash_tables( struct table_view *tv )
+{
+    UINT i;
+
+    for (i = 0; i < tv->num_cols; i++)
+    {
+        free( tv->columns[i].hash_table );
+        tv->columns[i].hash_table = NULL;
+    }
+}
+
 static UINT table_create_new_row( struct tagMSIVIEW *view, UINT *num, BOOL temporary )
 {
     struct table_view *tv = (struct table_view *)view;
@@ -1527,6 +1539,7 @@ static UINT table_create_new_row( struct tagMSIVIEW *view, UINT *num, BOOL tempo
     (*data_persist_ptr)[*row_count] = !temporary;
 
     (*row_count)++;
+    reset_hash_tables( tv );
 
     return ERROR_SUCCESS;
 }
@@ -1775,12 +1788,7 @@ static UINT TABLE_delete_row( struct tagMSIVIEW *view, UINT row )
     num_rows = tv->table->row_count;
     tv->table->row_count--;
 
-    /* reset the hash tables */
-    for (i = 0; i < tv->num_cols; i++)
-    {
-        free(tv->columns[i].hash_table);
-        tv->columns[i].hash_table = NULL;
-    }
+    reset_hash_tables( tv );
 
     for (i = row + 1; i < num_rows; i++)
     {
@@ -1964,6 +1972,7 @@ static UINT TABLE_remove_column(struct tagMSIVIEW *view, UINT number)
     if (tv->table->colinfo[number-1].type & MSITYPE_TEMPORARY)
     {
         UINT size = tv->table->colinfo[number-1].offset;
+        free(tv->table->colinfo[number-1].hash_table);
         tv->table->col_count--;
         tv->table->colinfo = realloc(tv->table->colinfo, sizeof(*tv->table->colinfo) * tv->table->col_count);
 
@@ -2182,6 +2191,78 @@ done:
     return r;
 }
 
+static UINT build_hash_table( struct table_view *tv, UINT col )
+{
+    struct column_info *column = &tv->columns[col - 1];
+    struct column_hash_entry **hash_table, *entry;
+    UINT i, size, num_rows = tv->table->row_count;
+
+    /* one bucket per row keeps the chains short on large tables */
+    size = max( num_rows, MSITABLE_HASH_TABLE_SIZE ) | 1;
+
+    /* allocate the buckets and the entries in one block so that
+     * invalidating the index is a single free */
+    hash_table = calloc( 1, size * sizeof(*hash_table) + num_rows * sizeof(*entry) );
+    if (!hash_table)
+        return ERROR_OUTOFMEMORY;
+
+    entry = (struct column_hash_entry *)(hash_table + size);
+
+    /* insert backwards so that each chain is in row order */
+    for (i = num_rows; i > 0; i--)
+    {
+        UINT value, r;
+
+        if ((r = TABLE_fetch_int( &tv->view, i - 1, col, &value )))
+        {
+            free( hash_table );
+            return r;
+        }
+        entry->value = value;
+        entry->row = i - 1;
+        entry->next = hash_table[value % size];
+        hash_table[value % size] = entry++;
+    }
+
+    column->hash_table = hash_table;
+    column->hash_size = size;
+    return ERROR_SUCCESS;
+}
+
+static UINT TABLE_find_matching_rows( struct tagMSIVIEW *view, UINT col, UINT val, UINT *row,
+                                      MSIITERHANDLE *handle )
+{
+    struct table_view *tv = (struct table_view *)view;
+    const struct column_hash_entry *entry;
+    UINT r;
+
+    TRACE("%p, %u, %u, %p\n", view, col, val, *handle);
+
+    if (!tv->table)
+        return ERROR_INVALID_PARAMETER;
+
+    if (col == 0 || col > tv->num_cols)
+        return ERROR_INVALID_PARAMETER;
+
+    if (!tv->columns[col - 1].hash_table && (r = build_hash_table( tv, col )))
+        return r;
+
+    if (!*handle)
+        entry = tv->columns[col - 1].hash_table[val % tv->columns[col - 1].hash_size];
+    else
+        entry = (*handle)->next;
+
+    while (entry && entry->value != val)
+        entry = entry->next;
+
+    *handle = entry;
+    if (!entry)
+        return ERROR_NO_MORE_ITEMS;
+
+    *row = entry->row;
+    return ERROR_SUCCESS;
+}
+
 static const MSIVIEWOPS table_ops =
 {
     TABLE_fetch_int,
@@ -2203,6 +2284,7 @@ static const MSIVIEWOPS table_ops =
     TABLE_add_column,
     NULL,
     TABLE_drop,
+    TABLE_find_matching_rows,
 };
 
 UINT TABLE_CreateView( MSIDATABASE *db, LPCWSTR name, MSIVIEW **view )
@@ -3165,11 +3247,39 @@ static UINT row_matches( struct table_view *tv, UINT row, const UINT *data, UINT
 
 static UINT table_find_row( struct table_view *tv, MSIRECORD *rec, UINT *row, UINT *column )
 {
-    UINT i, r = ERROR_FUNCTION_FAILED, *data;
+    UINT i, r = ERROR_FUNCTION_FAILED, ret, *data;
+    MSIITERHANDLE handle = NULL;
 
     data = record_to_row( tv, rec );
     if( !data )
         return r;
+
+    /* if the first key column has an index, look it up there and check the rest
+     * of the key; inserts drop the indexes, so don't build one for a single lookup */
+    for( i = 0; i < tv->num_cols; i++ )
+        if ( tv->columns[i].type & MSITYPE_KEY ) break;
+
+    if ( i < tv->num_cols && tv->columns[i].hash_table )
+    {
+        UINT col = i + 1;
+
+        while ( (ret = TABLE_find_matching_rows( &tv->view, col, data[col - 1], &i, &handle )) == ERROR_SUCCESS )
+        {
+            r = row_matches( tv, i, data, column );
+            if( r == ERROR_SUCCESS )
+            {
+                *row = i;
+                break;
+            }
+        }
+        if ( ret == ERROR_SUCCESS || ret == ERROR_NO_MORE_ITEMS )
+        {
+            free( data );
+            return r;
+        }
+        r = ERROR_FUNCTION_FAILED;
+    }
+
     for( i = 0; i < tv->table->row_count; i++ )
     {
         r = row_matches( tv, i, data, column );
@@ -9365,6 +9365,140 @@ static void test_viewfetch_wraparound(void)
     DeleteFileA(msifile);
 }
 
+static void test_indexed_where(void)
+{
+    MSIHANDLE hdb, view, rec;
+    char query[256];
+    UINT r, i;
+
+    hdb = create_db();
+    ok( hdb, "failed to create db\n" );
+
+    r = run_query( hdb, 0, "CREATE TABLE `Parent` ( `Key` CHAR(32) NOT NULL, `Value` SHORT, "
+                           "`Size` LONG PRIMARY KEY `Key`)" );
+    ok( r == ERROR_SUCCESS, "failed to create table: %u\n", r );
+
+    r = run_query( hdb, 0, "CREATE TABLE `Child` ( `Id` LONG NOT NULL, `Parent` CHAR(32) "
+                           "PRIMARY KEY `Id`)" );
+    ok( r == ERROR_SUCCESS, "failed to create table: %u\n", r );
+
+    for (i = 0; i < 50; i++)
+    {
+        sprintf( query, "INSERT INTO `Parent` ( `Key`, `Value`, `Size` ) VALUES ( 'key%u', %d, %d )",
+                 i, (int)i - 25, (int)i * 100000 );
+        r = run_query( hdb, 0, query );
+        ok( r == ERROR_SUCCESS, "failed to insert row %u: %u\n", i, r );
+    }
+    for (i = 0; i < 100; i++)
+    {
+        sprintf( query, "INSERT INTO `Child` ( `Id`, `Parent` ) VALUES ( %u, 'key%u' )", i, i % 50 );
+        r = run_query( hdb, 0, query );
+        ok( r == ERROR_SUCCESS, "failed to insert row %u: %u\n", i, r );
+    }
+
+    r = do_query( hdb, "SELECT `Value` FROM `Parent` WHERE `Key` = 'key17'", &rec );
+    ok( r == ERROR_SUCCESS, "got %u\n", r );
+    check_record( rec, 1, "-8" );
+    MsiCloseHandle( rec );
+
+    r = do_query( hdb, "SELECT `Key` FROM `Parent` WHERE `Value` = -3", &rec );
+    ok( r == ERROR_SUCCESS, "got %u\n", r );
+    check_record( rec, 1, "key22" );
+    MsiCloseHandle( rec );
+
+    r = do_query( hdb, "SELECT `Key` FROM `Parent` WHERE `Size` = 4000000 AND `Value` > 0", &rec );
+    ok( r == ERROR_SUCCESS, "got %u\n", r );
+    check_record( rec, 1, "key40" );
+    MsiCloseHandle( rec );
+
+    r = do_query( hdb, "SELECT `Key` FROM `Parent` WHERE `Key` = 'missing'", &rec );
+    ok( r == ERROR_NO_MORE_ITEMS, "got %u\n", r );
+
+    r = MsiDatabaseOpenViewA( hdb, "SELECT `Child`.`Id`, `Parent`.`Value` FROM `Parent`, `Child` "
+                              "WHERE `Child`.`Parent` = `Parent`.`Key` AND `Parent`.`Value` <= -24 "
+                              "ORDER BY `Id`", &view );
+    ok( r == ERROR_SUCCESS, "failed to open view: %u\n", r );
+    r = MsiViewExecute( view, 0 );
+    ok( r == ERROR_SUCCESS, "failed to execute view: %u\n", r );
+    r = MsiViewFetch( view, &rec );
+    ok( r == ERROR_SUCCESS, "got %u\n", r );
+    check_record( rec, 2, "0", "-25" );
+    MsiCloseHandle( rec );
+    r = MsiViewFetch( view, &rec );
+    ok( r == ERROR_SUCCESS, "got %u\n", r );
+    check_record( rec, 2, "1", "-24" );
+    MsiCloseHandle( rec );
+    r = MsiViewFetch( view, &rec );
+    ok( r == ERROR_SUCCESS, "got %u\n", r );
+    check_record( rec, 2, "50", "-25" );
+    MsiCloseHandle( rec );
+    r = MsiViewFetch( view, &rec );
+    ok( r == ERROR_SUCCESS, "got %u\n", r );
+    check_record( rec, 2, "51", "-24" );
+    MsiCloseHandle( rec );
+    r = MsiViewFetch( view, &rec );
+    ok( r == ERROR_NO_MORE_ITEMS, "got %u\n", r );
+    MsiViewClose( view );
+    MsiCloseHandle( view );
+
+    /* the indexes must follow changes to the table */
+    r = run_query( hdb, 0, "DELETE FROM `Parent` WHERE `Key` = 'key17'" );
+    ok( r == ERROR_SUCCESS, "failed to delete row: %u\n", r );
+    r = do_query( hdb, "SELECT `Value` FROM `Parent` WHERE `Key` = 'key17'", &rec );
+    ok( r == ERROR_NO_MORE_ITEMS, "got %u\n", r );
+    r = do_query( hdb, "SELECT `Key` FROM `Parent` WHERE `Value` = -7", &rec );
+    ok( r == ERROR_SUCCESS, "got %u\n", r );
+    check_record( rec, 1, "key18" );
+    MsiCloseHandle( rec );
+
+    r = run_query( hdb, 0, "INSERT INTO `Parent` ( `Key`, `Value`, `Size` ) VALUES ( 'key17', 100, 0 )" );
+    ok( r == ERROR_SUCCESS, "failed to insert row: %u\n", r );
+    r = run_query( hdb, 0, "INSERT INTO `Parent` ( `Key`, `Value`, `Size` ) VALUES ( 'key18', 100, 0 )" );
+    ok( r == ERROR_FUNCTION_FAILED, "got %u\n", r );
+    r = run_query( hdb, 0, "UPDATE `Parent` SET `Value` = 200 WHERE `Value` = 100" );
+    ok( r == ERROR_SUCCESS, "failed to update row: %u\n", r );
+    r = do_query( hdb, "SELECT `Key` FROM `Parent` WHERE `Value` = 200", &rec );
+    ok( r == ERROR_SUCCESS, "got %u\n", r );
+    check_record( rec, 1, "key17" );
+    MsiCloseHandle( rec );
+    r = do_query( hdb, "SELECT `Parent`.`Key` FROM `Child`, `Parent` "
+                  "WHERE `Child`.`Id` = 67 AND `Parent`.`Key` = `Child`.`Parent`", &rec );
+    ok( r == ERROR_SUCCESS, "got %u\n", r );
+    check_record( rec, 1, "key17" );
+    MsiCloseHandle( rec );
+
+    /* inserts after an indexed query, with and without the index in place */
+    r = do_query( hdb, "SELECT `Value` FROM `Parent` WHERE `Key` = 'key3'", &rec );
+    ok( r == ERROR_SUCCESS, "got %u\n", r );
+    check_record( rec, 1, "-22" );
+    MsiCloseHandle( rec );
+    r = run_query( hdb, 0, "INSERT INTO `Parent` ( `Key`, `Value`, `Size` ) VALUES ( 'key3', 1, 0 )" );
+    ok( r == ERROR_FUNCTION_FAILED, "got %u\n", r );
+    for (i = 0; i < 200; i++)
+    {
+        sprintf( query, "INSERT INTO `Parent` ( `Key`, `Value`, `Size` ) VALUES ( 'new%u', %u, 0 )", i, i );
+        r = run_query( hdb, 0, query );
+        ok( r == ERROR_SUCCESS, "failed to insert row %u: %u\n", i, r );
+    }
+    r = run_query( hdb, 0, "INSERT INTO `Parent` ( `Key`, `Value`, `Size` ) VALUES ( 'new100', 1, 0 )" );
+    ok( r == ERROR_FUNCTION_FAILED, "got %u\n", r );
+    r = do_query( hdb, "SELECT `Value` FROM `Parent` WHERE `Key` = 'new150'", &rec );
+    ok( r == ERROR_SUCCESS, "got %u\n", r );
+    check_record( rec, 1, "150" );
+    MsiCloseHandle( rec );
+    r = run_query( hdb, 0, "INSERT INTO `Parent` ( `Key`, `Value`, `Size` ) VALUES ( 'new199', 1, 0 )" );
+    ok( r == ERROR_FUNCTION_FAILED, "got %u\n", r );
+    r = run_query( hdb, 0, "INSERT INTO `Parent` ( `Key`, `Value`, `Size` ) VALUES ( 'new200', 300, 0 )" );
+    ok( r == ERROR_SUCCESS, "got %u\n", r );
+    r = do_query( hdb, "SELECT `Key` FROM `Parent` WHERE `Value` = 300", &rec );
+    ok( r == ERROR_SUCCESS, "got %u\n", r );
+    check_record( rec, 1, "new200" );
+    MsiCloseHandle( rec );
+
+    MsiCloseHandle( hdb );
+    DeleteFileA( msifile );
+}
+
 START_TEST(db)
 {
     test_msidatabase();
@@ -9425,4 +9559,5 @@ START_TEST(db)
     test_viewmodify_insert();
     test_view_get_error();
     test_viewfetch_wraparound();
+    test_indexed_where();
 }
@@ -647,15 +647,125 @@ static UINT WHERE_evaluate( MSIWHEREVIEW *wv, const UINT rows[],
     return ERROR_SUCCESS;
 }
 
+static BOOL is_bound_column( const struct expr *expr, const UINT rows[] )
+{
+    switch (expr->type)
+    {
+    case EXPR_COL_NUMBER:
+    case EXPR_COL_NUMBER32:
+    case EXPR_COL_NUMBER_STRING:
+        return rows[expr->u.column.parsed.table->table_index] != INVALID_ROW_INDEX;
+    default:
+        return FALSE;
+    }
+}
+
+/* Looks for an equality in the top level conjunction of the condition that
+ * ties a column of the given table to a constant or to a column of a table
+ * whose row is already fixed, and returns the raw value rows must have in
+ * that column. Returns ERROR_NO_MORE_ITEMS if no row can match. */
+static UINT find_index_key( MSIWHEREVIEW *wv, const UINT rows[], struct expr *cond,
+                            const struct join_table *table, UINT *col, UINT *key )
+{
+    struct expr *column, *value;
+    UINT i, r, id;
+    INT val;
+
+    if (!cond || (cond->type != EXPR_COMPLEX && cond->type != EXPR_STRCMP))
+        return ERROR_NOT_FOUND;
+
+    if (cond->type == EXPR_COMPLEX && cond->u.expr.op == OP_AND)
+    {
+        r = find_index_key( wv, rows, cond->u.expr.left, table, col, key );
+        if (r == ERROR_NOT_FOUND)
+            r = find_index_key( wv, rows, cond->u.expr.right, table, col, key );
+        return r;
+    }
+
+    if (cond->u.expr.op != OP_EQ)
+        return ERROR_NOT_FOUND;
+
+    for (i = 0; i < 2; i++)
+    {
+        column = i ? cond->u.expr.right : cond->u.expr.left;
+        value = i ? cond->u.expr.left : cond->u.expr.right;
+
+        if (column->type != EXPR_COL_NUMBER && column->type != EXPR_COL_NUMBER32 &&
+            column->type != EXPR_COL_NUMBER_STRING)
+            continue;
+        if (column->u.column.parsed.table != table)
+            continue;
+
+        *col = column->u.column.parsed.column;
+
+        if (cond->type == EXPR_STRCMP)
+        {
+            const WCHAR *str;
+
+            if (column->type != EXPR_COL_NUMBER_STRING)
+                continue;
+
+            /* empty strings also match null values */
+            if (value->type == EXPR_SVAL)
+            {
+                if (!value->u.sval[0])
+                    continue;
+                if (msi_string2id( wv->db->strings, value->u.sval, -1, key ) != ERROR_SUCCESS)
+                    return ERROR_NO_MORE_ITEMS;
+                return ERROR_SUCCESS;
+            }
+
+            if (value->type != EXPR_COL_NUMBER_STRING || !is_bound_column( value, rows ))
+                continue;
+            if (expr_fetch_value( &value->u.column, rows, &id ) != ERROR_SUCCESS)
+                continue;
+            str = msi_string_lookup( wv->db->strings, id, NULL );
+            if (!str || !str[0])
+                continue;
+            *key = id;
+            return ERROR_SUCCESS;
+        }
+
+        if (column->type == EXPR_COL_NUMBER_STRING)
+            continue;
+        if (value->type != EXPR_UVAL &&
+            (value->type == EXPR_COL_NUMBER_STRING || !is_bound_column( value, rows )))
+            continue;
+        if (WHERE_evaluate( wv, rows, value, &val, NULL ) != ERROR_SUCCESS)
+            continue;
+
+        /* undo the bias WHERE_evaluate applies to column values */
+        *key = val + (column->type == EXPR_COL_NUMBER ? 0x8000 : 0x80000000);
+        return ERROR_SUCCESS;
+    }
+
+    return ERROR_NOT_FOUND;
+}
+
 static UINT check_condition( MSIWHEREVIEW *wv, MSIRECORD *record, struct join_table **tables,
                              UINT table_rows[] )
 {
-    UINT r = ERROR_FUNCTION_FAILED;
+    struct join_table *table = *tables;
+    MSIITERHANDLE handle = NULL;
+    UINT r, col, key, row = 0;
+    BOOL indexed;
     INT val;
 
-    for (table_rows[(*tables)->table_index] = 0;
-         table_rows[(*tables)->table_index] < (*tables)->row_count;
-         table_rows[(*tables)->table_index]++)
+    /* when an equality pins down a column of this table, only visit the rows
+     * found through the column's index instead of scanning the whole table */
+    r = ERROR_NOT_FOUND;
+    if (table->view->ops->find_matching_rows)
+        r = find_index_key( wv, table_rows, wv->cond, table, &col, &key );
+    if (r == ERROR_SUCCESS)
+        r = table->view->ops->find_matching_rows( table->view, col, key, &row, &handle );
+    if (r == ERROR_NO_MORE_ITEMS)
+        return ERROR_SUCCESS;
+    indexed = (r == ERROR_SUCCESS);
+
+    r = ERROR_FUNCTION_FAILED;
+    for (table_rows[table->table_index] = row;
+         table_rows[table->table_index] < table->row_count;
+         table_rows[table->table_index] = row)
     {
         val = 0;
         wv->rec_index = 0;
@@ -677,8 +787,13 @@ static UINT check_condition( MSIWHEREVIEW *wv, MSIRECORD *record, struct join_ta
                 add_row (wv, table_rows);
             }
         }
+
+        if (!indexed)
+            row++;
+        else if (table->view->ops->find_matching_rows( table->view, col, key, &row, &handle ))
+            break;
     }
-    table_rows[(*tables)->table_index] = INVALID_ROW_INDEX;
+    table_rows[table->table_index] = INVALID_ROW_INDEX;
     return r;
 }
 
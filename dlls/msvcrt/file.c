@@ -2961,6 +2961,16 @@ static int read_utf8(ioinfo *fdinfo, wchar_t *buf, unsigned int count)
  * the file pointer on the \r character while getc() goes on to
  * the following \n
  */
+/* returns the number of leading chars that don't need text mode translation on read */
+static DWORD text_run_len(const char *buf, DWORD count)
+{
+    const char *end;
+
+    if ((end = memchr(buf, '\r', count))) count = end - buf;
+    if ((end = memchr(buf, 0x1a, count))) count = end - buf;
+    return count;
+}
+
 static int read_i(int fd, ioinfo *fdinfo, void *buf, unsigned int count)
 {
     DWORD num_read, utf16;
@@ -3035,6 +3045,20 @@ static int read_i(int fd, ioinfo *fdinfo, void *buf, unsigned int count)
 
             for (i=0, j=0; i<num_read; i+=1+utf16)
             {
+                if (!utf16)
+                {
+                    /* move runs that need no translation in one go */
+                    DWORD len = text_run_len(bufstart + i, num_read - i);
+
+                    if (len)
+                    {
+                        if (i != j) memmove(bufstart + j, bufstart + i, len);
+                        i += len;
+                        j += len;
+                        if (i == num_read) break;
+                    }
+                }
+
                 /* in text mode, a ctrl-z signals EOF */
                 if (bufstart[i]==0x1a && (!utf16 || bufstart[i+1]==0))
                 {
@@ -3725,11 +3749,20 @@ int CDECL _write(int fd, const void* buf, unsigned int count)
         }
         else if (ioinfo_get_textmode(info) == TEXTMODE_ANSI)
         {
-            for (j = 0; i < count && j < sizeof(lfbuf)-1; i++, j++)
+            while (i < count && j < sizeof(lfbuf)-1)
             {
-                if (s[i] == '\n')
+                DWORD len = min(count - i, sizeof(lfbuf) - 1 - j);
+                const char *nl = memchr(s + i, '\n', len);
+
+                if (nl) len = nl - (s + i);
+                memcpy(lfbuf + j, s + i, len);
+                i += len;
+                j += len;
+                if (nl)
+                {
                     lfbuf[j++] = '\r';
-                lfbuf[j] = s[i];
+                    lfbuf[j++] = s[i++];
+                }
             }
         }
         else if (ioinfo_get_textmode(info) == TEXTMODE_UTF16LE || console)
@@ -3974,8 +4007,23 @@ char * CDECL fgets(char *s, int size, FILE* file)
 
   _lock_file(file);
 
-  while ((size >1) && (cc = _fgetc_nolock(file)) != EOF && cc != '\n')
+  while (size > 1)
     {
+      /* copy whole runs out of the buffer instead of going char by char */
+      if (file->_cnt > 0)
+        {
+          int len = min(file->_cnt, size - 1);
+          char *nl = memchr(file->_ptr, '\n', len);
+
+          if (nl) len = nl - file->_ptr;
+          memcpy(s, file->_ptr, len);
+          s += len;
+          size -= len;
+          file->_ptr += len;
+          file->_cnt -= len;
+          if (size <= 1) break;
+        }
+      if ((cc = _fgetc_nolock(file)) == EOF || cc == '\n') break;
       *s++ = (char)cc;
       size --;
     }
@@ -742,6 +742,97 @@ static inline BOOL bnum_to_mant(struct bnum *b, ULONGLONG *m)
     return TRUE;
 }
 
+/* Largest decimal mantissa handled by fpnum_parse_fast. */
+#define FAST_MAX_DIGITS 19
+
+static ULONGLONG umul128(ULONGLONG a, ULONGLONG b, ULONGLONG *hi)
+{
+    ULONGLONG a0 = (ULONG)a, a1 = a >> 32, b0 = (ULONG)b, b1 = b >> 32;
+    ULONGLONG p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+    ULONGLONG mid = (p00 >> 32) + (ULONG)p01 + (ULONG)p10;
+
+    *hi = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+    return (mid << 32) | (ULONG)p00;
+}
+
+static int clz64(ULONGLONG x)
+{
+    int n = 0;
+
+    if (!(x >> 32)) { n += 32; x <<= 32; }
+    if (!(x >> 48)) { n += 16; x <<= 16; }
+    if (!(x >> 56)) { n += 8; x <<= 8; }
+    if (!(x >> 60)) { n += 4; x <<= 4; }
+    if (!(x >> 62)) { n += 2; x <<= 2; }
+    if (!(x >> 63)) n++;
+    return n;
+}
+
+/* Converts d * 10^e10 to fpnum without going through bnum when it can be done
+ * exactly with 128-bit integer arithmetic: d * 5^e10 for 5^e10 < 2^64, or a
+ * short division of d * 2^64 by 5^-e10 for 5^-e10 < 2^32. The result keeps the
+ * exact rounding information, so it's identical to the bnum path. */
+static BOOL fpnum_parse_fast(int sign, ULONGLONG d, int e10, struct fpnum *ret)
+{
+    ULONGLONG hi, lo, p5 = 1, rem = 0, dropped, half;
+    enum fpmod mod;
+    int exp, sh, i;
+
+    if (e10 > 27 || e10 < -13) return FALSE;
+    for (i = 0; i < (e10 < 0 ? -e10 : e10); i++) p5 *= 5;
+
+    if (e10 >= 0)
+    {
+        lo = umul128(d, p5, &hi);
+        exp = e10;
+    }
+    else
+    {
+        ULONG q[4];
+
+        sh = clz64(d);
+        d <<= sh;
+        q[3] = (d >> 32) / p5;
+        rem = (d >> 32) % p5;
+        q[2] = ((rem << 32) | (ULONG)d) / p5;
+        rem = ((rem << 32) | (ULONG)d) % p5;
+        q[1] = (rem << 32) / p5;
+        rem = (rem << 32) % p5;
+        q[0] = (rem << 32) / p5;
+        rem = (rem << 32) % p5;
+        hi = ((ULONGLONG)q[3] << 32) | q[2];
+        lo = ((ULONGLONG)q[1] << 32) | q[0];
+        exp = e10 - 64 - sh;
+    }
+
+    if (!hi)
+    {
+        *ret = fpnum(sign, exp, lo, FP_ROUND_ZERO);
+        return TRUE;
+    }
+
+    sh = 64 - clz64(hi);
+    if (sh == 64)
+    {
+        dropped = lo;
+        lo = hi;
+    }
+    else
+    {
+        dropped = lo & (((ULONGLONG)1 << sh) - 1);
+        lo = (hi << (64 - sh)) | (lo >> sh);
+    }
+    exp += sh;
+
+    half = (ULONGLONG)1 << (sh - 1);
+    if (dropped & half)
+        mod = (dropped & (half - 1)) || rem ? FP_ROUND_UP : FP_ROUND_EVEN;
+    else
+        mod = dropped || rem ? FP_ROUND_DOWN : FP_ROUND_ZERO;
+    *ret = fpnum(sign, exp, lo, mod);
+    return TRUE;
+}
+
 static struct fpnum fpnum_parse_bnum(wchar_t (*get)(void *ctx), void (*unget)(void *ctx),
         void *ctx, pthreadlocinfo locinfo, BOOL ldouble, struct bnum *b)
 {
@@ -755,7 +846,9 @@ static struct fpnum fpnum_parse_bnum(wchar_t (*get)(void *ctx), void (*unget)(vo
     int e2 = 0, dp=0, sign=1, off, limb_digits = 0, i;
     enum fpmod round = FP_ROUND_ZERO;
     wchar_t nch;
-    ULONGLONG m;
+    ULONGLONG m, fast_m = 0;
+    int fast_digits = 0;
+    struct fpnum fp;
 
     nch = get(ctx);
     if(nch == '-') {
@@ -825,12 +918,14 @@ static struct fpnum fpnum_parse_bnum(wchar_t (*get)(void *ctx), void (*unget)(vo
         }
 
         b->data[bnum_idx(b, b->b)] = b->data[bnum_idx(b, b->b)] * 10 + nch - '0';
+        if(++fast_digits <= FAST_MAX_DIGITS) fast_m = fast_m * 10 + nch - '0';
         limb_digits++;
         nch = get(ctx);
         dp++;
     }
     while(nch>='0' && nch<='9') {
         if(nch != '0') b->data[bnum_idx(b, b->b)] |= 1;
+        fast_digits++;
         nch = get(ctx);
         dp++;
     }
@@ -861,11 +956,13 @@ static struct fpnum fpnum_parse_bnum(wchar_t (*get)(void *ctx), void (*unget)(vo
         }
 
         b->data[bnum_idx(b, b->b)] = b->data[bnum_idx(b, b->b)] * 10 + nch - '0';
+        if(++fast_digits <= FAST_MAX_DIGITS) fast_m = fast_m * 10 + nch - '0';
         limb_digits++;
         nch = get(ctx);
     }
     while(nch>='0' && nch<='9') {
         if(nch != '0') b->data[bnum_idx(b, b->b)] |= 1;
+        fast_digits++;
         nch = get(ctx);
     }
 
@@ -917,6 +1014,11 @@ static struct fpnum fpnum_parse_bnum(wchar_t (*get)(void *ctx), void (*unget)(vo
     if(!b->data[bnum_idx(b, b->e-1)])
         return fpnum(sign, 0, 0, 0);
 
+    if(!ldouble && fast_digits <= FAST_MAX_DIGITS &&
+            dp > INT_MIN + FAST_MAX_DIGITS && dp < INT_MAX &&
+            fpnum_parse_fast(sign, fast_m, dp - fast_digits, &fp))
+        return fp;
+
     /* Fill last limb with 0 if needed */
     if(b->b+1 != b->e) {
         for(; limb_digits != LIMB_DIGITS; limb_digits++)
@@ -1560,13 +1662,28 @@ int CDECL _atoldbl(_LDOUBLE *value, char *str)
     return _atoldbl_l( (MSVCRT__LDOUBLE*)value, str, NULL );
 }
 
+/* Helpers for scanning strings a machine word at a time. Words are only read
+ * from aligned addresses, so they never cross a page boundary past the end of
+ * the string. */
+#define WORD_ONES  ((size_t)-1 / 0xff)
+#define WORD_HIGHS (WORD_ONES * 0x80)
+
+static inline BOOL word_has_zero_byte(size_t x)
+{
+    return ((x - WORD_ONES) & ~x & WORD_HIGHS) != 0;
+}
+
 /*********************************************************************
  *              strlen (MSVCRT.@)
  */
 size_t __cdecl strlen(const char *str)
 {
     const char *s = str;
-    while (*s) s++;
+    const size_t *w;
+
+    for (; (size_t)s % sizeof(size_t); s++) if (!*s) return s - str;
+    for (w = (const size_t *)s; !word_has_zero_byte(*w); w++);
+    for (s = (const char *)w; *s; s++);
     return s - str;
 }
 
@@ -3249,6 +3366,17 @@ void *__cdecl memset(void *dst, int c, size_t n)
  */
 char* __cdecl strchr(const char *str, int c)
 {
+    size_t mask = WORD_ONES * (unsigned char)c;
+    const size_t *w;
+
+    for (; (size_t)str % sizeof(size_t); str++)
+    {
+        if (*str == (char)c) return (char*)str;
+        if (!*str) return NULL;
+    }
+    for (w = (const size_t *)str; !word_has_zero_byte(*w) && !word_has_zero_byte(*w ^ mask); w++);
+    str = (const char *)w;
+
     do
     {
         if (*str == (char)c) return (char*)str;
@@ -3272,8 +3400,13 @@ char* __cdecl strrchr(const char *str, int c)
 void* __cdecl memchr(const void *ptr, int c, size_t n)
 {
     const unsigned char *p = ptr;
+    size_t mask = WORD_ONES * (unsigned char)c;
 
-    for (p = ptr; n; n--, p++) if (*p == (unsigned char)c) return (void *)(ULONG_PTR)p;
+    for (; (size_t)p % sizeof(size_t) && n; n--, p++)
+        if (*p == (unsigned char)c) return (void *)(ULONG_PTR)p;
+    for (; n >= sizeof(size_t); n -= sizeof(size_t), p += sizeof(size_t))
+        if (word_has_zero_byte(*(const size_t *)p ^ mask)) break;
+    for (; n; n--, p++) if (*p == (unsigned char)c) return (void *)(ULONG_PTR)p;
     return NULL;
 }
 
@@ -3282,7 +3415,19 @@ void* __cdecl memchr(const void *ptr, int c, size_t n)
  */
 int __cdecl strcmp(const char *str1, const char *str2)
 {
+    if ((size_t)str1 % sizeof(size_t) == (size_t)str2 % sizeof(size_t))
+    {
+        const size_t *w1, *w2;
+
+        for (; (size_t)str1 % sizeof(size_t); str1++, str2++)
+            if (!*str1 || *str1 != *str2) goto done;
+        for (w1 = (const size_t *)str1, w2 = (const size_t *)str2;
+             *w1 == *w2 && !word_has_zero_byte(*w1); w1++, w2++);
+        str1 = (const char *)w1;
+        str2 = (const char *)w2;
+    }
     while (*str1 && *str1 == *str2) { str1++; str2++; }
+done:
     if ((unsigned char)*str1 > (unsigned char)*str2) return 1;
     if ((unsigned char)*str1 < (unsigned char)*str2) return -1;
     return 0;
@@ -2969,7 +2969,17 @@ wchar_t* CDECL wcsrchr(const wchar_t *str, wchar_t ch)
  */
 size_t CDECL wcslen(const wchar_t *str)
 {
+    static const size_t ones = (size_t)-1 / 0xffff, highs = (size_t)-1 / 0xffff * 0x8000;
     const wchar_t *s = str;
+    const size_t *w;
+
+    /* scan a machine word at a time from an aligned address, so that reads
+     * never cross a page boundary past the terminator */
+    if ((size_t)s % sizeof(wchar_t)) goto done;
+    for (; (size_t)s % sizeof(size_t); s++) if (!*s) return s - str;
+    for (w = (const size_t *)s; !((*w - ones) & ~*w & highs); w++);
+    s = (const wchar_t *)w;
+done:
     while (*s) s++;
     return s - str;
 }
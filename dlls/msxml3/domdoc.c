@@ -248,6 +248,25 @@ int registerNamespaces(xmlXPathContextPtr ctxt)
     return n;
 }
 
+/* Returns the registered selection namespaces as a single string, or NULL if
+ * there are none. Used to key compiled queries that depend on them. */
+xmlChar *get_selection_namespaces_key(xmlDocPtr doc)
+{
+    const struct list *pNsList = &properties_from_xmlDocPtr(doc)->selectNsList;
+    const select_ns_entry *ns;
+    xmlChar *key = NULL;
+
+    LIST_FOR_EACH_ENTRY( ns, pNsList, select_ns_entry, entry )
+    {
+        key = xmlStrcat(key, ns->prefix);
+        key = xmlStrcat(key, BAD_CAST "=");
+        key = xmlStrcat(key, ns->href);
+        key = xmlStrcat(key, BAD_CAST " ");
+    }
+
+    return key;
+}
+
 static inline void clear_selectNsList(struct list* pNsList)
 {
     select_ns_entry *ns, *ns2;
@@ -386,6 +386,7 @@ BOOL WINAPI DllMain(HINSTANCE hInstDLL, DWORD fdwReason, LPVOID reserved)
         xmlCleanupInputCallbacks();
         xmlRegisterDefaultInputCallbacks();
 
+        selection_cleanup();
         xmlCleanupParser();
         schemasCleanup();
         release_typelib();
@@ -93,6 +93,7 @@ struct xslprocessor_params
 
 extern void schemasInit(void);
 extern void schemasCleanup(void);
+extern void selection_cleanup(void);
 
 /* IXMLDOMNode Internal Structure */
 typedef struct _xmlnode
@@ -139,6 +140,7 @@ extern IUnknown         *create_doc_fragment( xmlNodePtr );
 extern IUnknown         *create_doc_entity_ref( xmlNodePtr );
 extern IUnknown         *create_doc_type( xmlNodePtr );
 extern HRESULT           create_selection( xmlNodePtr, xmlChar*, IXMLDOMNodeList** );
+extern HRESULT           select_single_node( xmlNodePtr, xmlChar*, IXMLDOMNode** );
 extern HRESULT           create_enumvariant( IUnknown*, BOOL, const struct enumvariant_funcs*, IEnumVARIANT**);
 extern HRESULT           create_dom_implementation(IXMLDOMImplementation **obj);
 
@@ -1571,18 +1571,18 @@ HRESULT node_select_nodes(const xmlnode *This, BSTR query, IXMLDOMNodeList **nod
 
 HRESULT node_select_singlenode(const xmlnode *This, BSTR query, IXMLDOMNode **node)
 {
-    IXMLDOMNodeList *list;
+    xmlChar* str;
     HRESULT hr;
 
     if (node)
         *node = NULL;
 
-    hr = node_select_nodes(This, query, &list);
-    if (hr == S_OK)
-    {
-        hr = IXMLDOMNodeList_nextNode(list, node);
-        IXMLDOMNodeList_Release(list);
-    }
+    if (!query || !node) return E_INVALIDARG;
+
+    str = xmlchar_from_wchar(query);
+    hr = select_single_node(This->node, str, node);
+    free(str);
+
     return hr;
 }
 
@@ -51,8 +51,38 @@
 WINE_DEFAULT_DEBUG_CHANNEL(msxml);
 
 int registerNamespaces(xmlXPathContextPtr ctxt);
+xmlChar *get_selection_namespaces_key(xmlDocPtr doc);
 xmlChar* XSLPattern_to_XPath(xmlXPathContextPtr ctxt, xmlChar const* xslpat_str);
 
+/* Compiled queries are kept in a small MRU list, so that repeated
+ * selectNodes()/selectSingleNode() calls with the same query skip the
+ * XSLPattern translation and the libxml2 compilation step. An entry is
+ * taken off the list while it's being evaluated, so it's never used by two
+ * threads at once. XSLPattern translation depends on the registered
+ * selection namespaces, so those are part of the key. */
+#define QUERY_CACHE_SIZE 32
+
+struct query_cache_entry
+{
+    struct list entry;
+    BOOL xpath;
+    xmlChar *query;
+    xmlChar *namespaces;
+    xmlXPathCompExprPtr comp;
+};
+
+static struct list query_cache = LIST_INIT(query_cache);
+static unsigned int query_cache_count;
+
+static CRITICAL_SECTION query_cache_cs;
+static CRITICAL_SECTION_DEBUG query_cache_cs_dbg =
+{
+    0, 0, &query_cache_cs,
+    { &query_cache_cs_dbg.ProcessLocksList, &query_cache_cs_dbg.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": query_cache") }
+};
+static CRITICAL_SECTION query_cache_cs = { &query_cache_cs_dbg, -1, 0, 0, 0, 0 };
+
 typedef struct
 {
     IEnumVARIANT IEnumVARIANT_iface;
@@ -761,44 +791,118 @@ static void query_serror(void* ctx, const xmlError* err)
     LIBXML2_CALLBACK_SERROR(domselection_create, err);
 }
 
-HRESULT create_selection(xmlNodePtr node, xmlChar* query, IXMLDOMNodeList **out)
+static void free_query_cache_entry(struct query_cache_entry *entry)
 {
-    domselection *This = malloc(sizeof(domselection));
-    xmlXPathContextPtr ctxt = xmlXPathNewContext(node->doc);
-    HRESULT hr;
+    xmlXPathFreeCompExpr(entry->comp);
+    xmlFree(entry->query);
+    xmlFree(entry->namespaces);
+    free(entry);
+}
 
-    TRACE("(%p, %s, %p)\n", node, debugstr_a((char const*)query), out);
+static BOOL query_cache_entry_matches(const struct query_cache_entry *entry, BOOL xpath,
+        const xmlChar *query, const xmlChar *namespaces)
+{
+    return entry->xpath == xpath && xmlStrEqual(entry->query, query) &&
+            xmlStrEqual(entry->namespaces, namespaces);
+}
 
-    *out = NULL;
-    if (!This || !ctxt || !query)
+static struct query_cache_entry *query_cache_get(BOOL xpath, const xmlChar *query, const xmlChar *namespaces)
+{
+    struct query_cache_entry *entry;
+
+    EnterCriticalSection(&query_cache_cs);
+    LIST_FOR_EACH_ENTRY(entry, &query_cache, struct query_cache_entry, entry)
     {
-        xmlXPathFreeContext(ctxt);
-        free(This);
-        return E_OUTOFMEMORY;
+        if (query_cache_entry_matches(entry, xpath, query, namespaces))
+        {
+            list_remove(&entry->entry);
+            query_cache_count--;
+            LeaveCriticalSection(&query_cache_cs);
+            return entry;
+        }
     }
+    LeaveCriticalSection(&query_cache_cs);
 
-    This->IXMLDOMSelection_iface.lpVtbl = &domselection_vtbl;
-    This->ref = 1;
-    This->resultPos = 0;
-    This->node = node;
-    This->enumvariant = NULL;
-    init_dispex(&This->dispex, (IUnknown*)&This->IXMLDOMSelection_iface, &domselection_dispex);
-    xmldoc_add_ref(This->node->doc);
+    return NULL;
+}
+
+static void query_cache_put(struct query_cache_entry *entry)
+{
+    struct query_cache_entry *cur, *evict = NULL;
+
+    EnterCriticalSection(&query_cache_cs);
+    LIST_FOR_EACH_ENTRY(cur, &query_cache, struct query_cache_entry, entry)
+    {
+        /* Another thread compiled the same query meanwhile. */
+        if (query_cache_entry_matches(cur, entry->xpath, entry->query, entry->namespaces))
+        {
+            LeaveCriticalSection(&query_cache_cs);
+            free_query_cache_entry(entry);
+            return;
+        }
+    }
+
+    list_add_head(&query_cache, &entry->entry);
+    if (++query_cache_count > QUERY_CACHE_SIZE)
+    {
+        evict = LIST_ENTRY(list_tail(&query_cache), struct query_cache_entry, entry);
+        list_remove(&evict->entry);
+        query_cache_count--;
+    }
+    LeaveCriticalSection(&query_cache_cs);
+
+    if (evict) free_query_cache_entry(evict);
+}
+
+void selection_cleanup(void)
+{
+    struct query_cache_entry *entry, *next;
+
+    LIST_FOR_EACH_ENTRY_SAFE(entry, next, &query_cache, struct query_cache_entry, entry)
+    {
+        list_remove(&entry->entry);
+        free_query_cache_entry(entry);
+    }
+    query_cache_count = 0;
+}
+
+static xmlXPathCompExprPtr compile_query(xmlXPathContextPtr ctxt, BOOL xpath, const xmlChar *query)
+{
+    xmlXPathCompExprPtr comp;
+    xmlChar *pattern_query;
+
+    if (xpath)
+        return xmlXPathCtxtCompile(ctxt, query);
+
+    pattern_query = XSLPattern_to_XPath(ctxt, query);
+    comp = xmlXPathCtxtCompile(ctxt, pattern_query);
+    xmlFree(pattern_query);
+    return comp;
+}
+
+static xmlXPathObjectPtr eval_query(xmlNodePtr node, const xmlChar *query)
+{
+    struct query_cache_entry *entry;
+    xmlXPathContextPtr ctxt;
+    xmlXPathObjectPtr result;
+    xmlChar *namespaces;
+    BOOL xpath;
+
+    if (!(ctxt = xmlXPathNewContext(node->doc)))
+        return NULL;
 
     ctxt->error = query_serror;
     ctxt->node = node;
     registerNamespaces(ctxt);
     xmlXPathContextSetCache(ctxt, 1, -1, 0);
 
-    if (is_xpathmode(This->node->doc))
+    if ((xpath = is_xpathmode(node->doc)))
     {
         xmlXPathRegisterAllFunctions(ctxt);
-        This->result = xmlXPathEvalExpression(query, ctxt);
+        namespaces = NULL;
     }
     else
     {
-        xmlChar* pattern_query = XSLPattern_to_XPath(ctxt, query);
-
         xmlXPathRegisterFunc(ctxt, (xmlChar const*)"not", xmlXPathNotFunction);
         xmlXPathRegisterFunc(ctxt, (xmlChar const*)"boolean", xmlXPathBooleanFunction);
 
@@ -813,23 +917,99 @@ HRESULT create_selection(xmlNodePtr node, xmlChar* query, IXMLDOMNodeList **out)
         xmlXPathRegisterFunc(ctxt, (xmlChar const*)"OP_IGt", XSLPattern_OP_IGt);
         xmlXPathRegisterFunc(ctxt, (xmlChar const*)"OP_IGEq", XSLPattern_OP_IGEq);
 
-        This->result = xmlXPathEvalExpression(pattern_query, ctxt);
-        xmlFree(pattern_query);
+        namespaces = get_selection_namespaces_key(node->doc);
     }
 
-    if (!This->result || This->result->type != XPATH_NODESET)
+    if (!(entry = query_cache_get(xpath, query, namespaces)))
     {
-        hr = E_FAIL;
-        goto cleanup;
+        xmlXPathCompExprPtr comp = compile_query(ctxt, xpath, query);
+
+        if (!comp || !(entry = malloc(sizeof(*entry))))
+        {
+            xmlXPathFreeCompExpr(comp);
+            xmlFree(namespaces);
+            xmlXPathFreeContext(ctxt);
+            return NULL;
+        }
+
+        entry->xpath = xpath;
+        entry->query = xmlStrdup(query);
+        entry->namespaces = namespaces;
+        entry->comp = comp;
     }
+    else
+        xmlFree(namespaces);
+
+    result = xmlXPathCompiledEval(entry->comp, ctxt);
+    query_cache_put(entry);
+    xmlXPathFreeContext(ctxt);
+
+    if (result && result->type != XPATH_NODESET)
+    {
+        xmlXPathFreeObject(result);
+        result = NULL;
+    }
+
+    return result;
+}
+
+HRESULT create_selection(xmlNodePtr node, xmlChar* query, IXMLDOMNodeList **out)
+{
+    domselection *This;
+    xmlXPathObjectPtr result;
+
+    TRACE("(%p, %s, %p)\n", node, debugstr_a((char const*)query), out);
+
+    *out = NULL;
+    if (!query)
+        return E_OUTOFMEMORY;
+
+    if (!(result = eval_query(node, query)))
+        return E_FAIL;
+
+    if (!(This = malloc(sizeof(domselection))))
+    {
+        xmlXPathFreeObject(result);
+        return E_OUTOFMEMORY;
+    }
+
+    This->IXMLDOMSelection_iface.lpVtbl = &domselection_vtbl;
+    This->ref = 1;
+    This->resultPos = 0;
+    This->node = node;
+    This->enumvariant = NULL;
+    This->result = result;
+    init_dispex(&This->dispex, (IUnknown*)&This->IXMLDOMSelection_iface, &domselection_dispex);
+    xmldoc_add_ref(This->node->doc);
 
     *out = (IXMLDOMNodeList*)&This->IXMLDOMSelection_iface;
-    hr = S_OK;
     TRACE("found %d matches\n", xmlXPathNodeSetGetLength(This->result->nodesetval));
+    return S_OK;
+}
 
-cleanup:
-    if (FAILED(hr))
-        IXMLDOMSelection_Release( &This->IXMLDOMSelection_iface );
-    xmlXPathFreeContext(ctxt);
+/* selectSingleNode() only needs the first match, so don't build a selection
+ * object around the result. */
+HRESULT select_single_node(xmlNodePtr node, xmlChar *query, IXMLDOMNode **out)
+{
+    xmlXPathObjectPtr result;
+    HRESULT hr = S_FALSE;
+
+    TRACE("(%p, %s, %p)\n", node, debugstr_a((char const*)query), out);
+
+    *out = NULL;
+    if (!query)
+        return E_OUTOFMEMORY;
+
+    if (!(result = eval_query(node, query)))
+        return E_FAIL;
+
+    if (xmlXPathNodeSetGetLength(result->nodesetval) > 0)
+    {
+        *out = create_node(xmlXPathNodeSetItem(result->nodesetval, 0));
+        hr = S_OK;
+    }
+
+    TRACE("found %d matches\n", xmlXPathNodeSetGetLength(result->nodesetval));
+    xmlXPathFreeObject(result);
     return hr;
 }
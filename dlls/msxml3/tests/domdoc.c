@@ -7673,6 +7673,7 @@ static void test_XSLPattern(void)
     const xslpattern_test_t *ptr = xslpattern_test;
     IXMLDOMDocument2 *doc;
     IXMLDOMNodeList *list;
+    IXMLDOMNode *node;
     VARIANT_BOOL b;
     HRESULT hr;
     LONG len;
@@ -7782,6 +7783,18 @@ static void test_XSLPattern(void)
     ok(len == 0, "expected empty list\n");
     IXMLDOMNodeList_Release(list);
 
+    /* unregistering it again restores document prefix matching for the same query */
+    hr = IXMLDOMDocument2_setProperty(doc, _bstr_("SelectionNamespaces"), _variantbstr_(""));
+    ok(hr == S_OK, "Unexpected hr %#lx.\n", hr);
+
+    hr = IXMLDOMDocument2_selectNodes(doc, _bstr_("//foo:c"), &list);
+    ok(hr == S_OK, "Unexpected hr %#lx.\n", hr);
+    expect_list_and_release(list, "E3.E4.E2.D1");
+
+    hr = IXMLDOMDocument2_selectSingleNode(doc, _bstr_("//foo:c"), &node);
+    ok(hr == S_OK, "Unexpected hr %#lx.\n", hr);
+    IXMLDOMNode_Release(node);
+
     IXMLDOMDocument2_Release(doc);
 
     doc = create_document(&IID_IXMLDOMDocument2);
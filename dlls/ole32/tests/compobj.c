@@ -862,6 +862,56 @@ static void test_CoGetClassObject(void)
     CoUninitialize();
 }
 
+static void test_CoGetClassObject_registry_changes(void)
+{
+    static const char keyA[] = "CLSID\\{82222222-1234-1234-1234-56789abcdef0}";
+    IUnknown *unk;
+    HRESULT hr;
+    HKEY hkey;
+    LONG res;
+
+    CoInitializeEx(NULL, COINIT_MULTITHREADED);
+
+    hr = CoGetClassObject(&IID_Testiface7, CLSCTX_INPROC_SERVER, NULL, &IID_IUnknown, (void **)&unk);
+    ok(hr == REGDB_E_CLASSNOTREG, "Unexpected hr %#lx.\n", hr);
+
+    res = RegCreateKeyExA(HKEY_CLASSES_ROOT, "CLSID\\{82222222-1234-1234-1234-56789abcdef0}\\InprocServer32",
+            0, NULL, 0, KEY_WRITE, NULL, &hkey, NULL);
+    if (res == ERROR_ACCESS_DENIED)
+    {
+        skip("Not authorized to modify the Classes key.\n");
+        CoUninitialize();
+        return;
+    }
+    ok(!res, "Failed to create a key, error %ld.\n", res);
+    res = RegSetValueExA(hkey, NULL, 0, REG_SZ, (const BYTE *)testlib, strlen(testlib) + 1);
+    ok(!res, "Failed to set a value, error %ld.\n", res);
+    res = RegSetValueExA(hkey, "ThreadingModel", 0, REG_SZ, (const BYTE *)"Both", sizeof("Both"));
+    ok(!res, "Failed to set a value, error %ld.\n", res);
+    RegCloseKey(hkey);
+
+    /* This one will load test dll and get back specific error code. */
+    hr = CoGetClassObject(&IID_Testiface7, CLSCTX_INPROC_SERVER, NULL, &IID_IUnknown, (void **)&unk);
+    ok(hr == 0x80001235, "Unexpected hr %#lx.\n", hr);
+
+    hr = CoGetClassObject(&IID_Testiface7, CLSCTX_INPROC_SERVER, NULL, &IID_IUnknown, (void **)&unk);
+    ok(hr == 0x80001235, "Unexpected hr %#lx.\n", hr);
+
+    res = RegOpenKeyExA(HKEY_CLASSES_ROOT, keyA, 0, KEY_ALL_ACCESS, &hkey);
+    ok(!res, "Failed to open a key, error %ld.\n", res);
+    res = RegDeleteKeyA(hkey, "InprocServer32");
+    ok(!res, "Failed to delete a key, error %ld.\n", res);
+    RegCloseKey(hkey);
+
+    hr = CoGetClassObject(&IID_Testiface7, CLSCTX_INPROC_SERVER, NULL, &IID_IUnknown, (void **)&unk);
+    ok(hr == REGDB_E_CLASSNOTREG, "Unexpected hr %#lx.\n", hr);
+
+    res = RegDeleteKeyA(HKEY_CLASSES_ROOT, keyA);
+    ok(!res, "Failed to delete a key, error %ld.\n", res);
+
+    CoUninitialize();
+}
+
 static void test_CoCreateInstanceEx(void)
 {
     MULTI_QI qi_res = { &IID_IMoniker };
@@ -4387,6 +4437,7 @@ START_TEST(compobj)
     test_CoCreateInstance();
     test_ole_menu();
     test_CoGetClassObject();
+    test_CoGetClassObject_registry_changes();
     test_CoCreateInstanceEx();
     test_CoRegisterMessageFilter();
     test_CoRegisterPSClsid();
@@ -110,6 +110,12 @@ typedef struct {
 
 static bstr_cache_entry_t bstr_cache[0x10000/BUCKET_SIZE];
 
+/* Small strings are cached per thread first, so that threads don't have to
+ * take cs_bstr_cache for them; the global cache takes the overflow. */
+#define THREAD_CACHE_BUCKETS 32
+
+static DWORD bstr_cache_fls = FLS_OUT_OF_INDEXES;
+
 static inline size_t bstr_alloc_size(size_t size)
 {
     return (FIELD_OFFSET(bstr_t, u.ptr[size]) + sizeof(WCHAR) + BUCKET_SIZE-1) & ~(BUCKET_SIZE-1);
@@ -120,48 +126,102 @@ static inline bstr_t *bstr_from_str(BSTR str)
     return CONTAINING_RECORD(str, bstr_t, u.str);
 }
 
-static inline bstr_cache_entry_t *get_cache_entry_from_idx(unsigned cache_idx)
+static inline bstr_t *cache_entry_pop(bstr_cache_entry_t *cache_entry)
 {
-    return bstr_cache_enabled && cache_idx < ARRAY_SIZE(bstr_cache) ? bstr_cache + cache_idx : NULL;
+    bstr_t *ret;
+
+    if(!cache_entry->cnt)
+        return NULL;
+
+    ret = cache_entry->buf[cache_entry->head++];
+    cache_entry->head %= BUCKET_BUFFER_SIZE;
+    cache_entry->cnt--;
+    return ret;
 }
 
-static inline bstr_cache_entry_t *get_cache_entry(size_t size)
+static inline BOOL cache_entry_push(bstr_cache_entry_t *cache_entry, bstr_t *bstr)
 {
-    unsigned cache_idx = FIELD_OFFSET(bstr_t, u.ptr[size+sizeof(WCHAR)-1])/BUCKET_SIZE;
-    return get_cache_entry_from_idx(cache_idx);
+    if(cache_entry->cnt == ARRAY_SIZE(cache_entry->buf))
+        return FALSE;
+
+    cache_entry->buf[(cache_entry->head+cache_entry->cnt) % BUCKET_BUFFER_SIZE] = bstr;
+    cache_entry->cnt++;
+    return TRUE;
 }
 
-static inline bstr_cache_entry_t *get_cache_entry_from_alloc_size(SIZE_T alloc_size)
+static inline BOOL cache_entry_contains(const bstr_cache_entry_t *cache_entry, const bstr_t *bstr)
 {
-    unsigned cache_idx;
-    if (alloc_size < BUCKET_SIZE) return NULL;
-    cache_idx = (alloc_size - BUCKET_SIZE) / BUCKET_SIZE;
-    return get_cache_entry_from_idx(cache_idx);
+    unsigned i;
+
+    for(i=0; i < cache_entry->cnt; i++)
+        if(cache_entry->buf[(cache_entry->head+i) % BUCKET_BUFFER_SIZE] == bstr)
+            return TRUE;
+    return FALSE;
 }
 
-static bstr_t *alloc_bstr(size_t size)
+static void WINAPI free_thread_cache(void *data)
 {
-    bstr_cache_entry_t *cache_entry = get_cache_entry(size);
-    bstr_t *ret;
+    bstr_cache_entry_t *thread_cache = data;
+    unsigned i;
+    bstr_t *bstr;
 
-    if(cache_entry) {
-        EnterCriticalSection(&cs_bstr_cache);
+    if(!thread_cache)
+        return;
+
+    EnterCriticalSection(&cs_bstr_cache);
+    for(i=0; i < THREAD_CACHE_BUCKETS; i++) {
+        while((bstr = cache_entry_pop(thread_cache + i))) {
+            if(!cache_entry_push(bstr_cache + i, bstr))
+                CoTaskMemFree(bstr);
+        }
+    }
+    LeaveCriticalSection(&cs_bstr_cache);
+
+    free(thread_cache);
+}
+
+static bstr_cache_entry_t *get_thread_cache(BOOL create)
+{
+    bstr_cache_entry_t *thread_cache;
+
+    if(bstr_cache_fls == FLS_OUT_OF_INDEXES)
+        return NULL;
 
-        if(!cache_entry->cnt) {
-            cache_entry = get_cache_entry(size+BUCKET_SIZE);
-            if(cache_entry && !cache_entry->cnt)
-                cache_entry = NULL;
+    thread_cache = FlsGetValue(bstr_cache_fls);
+    if(!thread_cache && create) {
+        thread_cache = calloc(THREAD_CACHE_BUCKETS, sizeof(*thread_cache));
+        if(thread_cache && !FlsSetValue(bstr_cache_fls, thread_cache)) {
+            free(thread_cache);
+            thread_cache = NULL;
         }
+    }
+    return thread_cache;
+}
 
-        if(cache_entry) {
-            ret = cache_entry->buf[cache_entry->head++];
-            cache_entry->head %= BUCKET_BUFFER_SIZE;
-            cache_entry->cnt--;
+static bstr_t *alloc_bstr(size_t size)
+{
+    unsigned cache_idx = FIELD_OFFSET(bstr_t, u.ptr[size+sizeof(WCHAR)-1])/BUCKET_SIZE;
+    bstr_cache_entry_t *thread_cache;
+    bstr_t *ret = NULL;
+
+    if(bstr_cache_enabled && cache_idx < ARRAY_SIZE(bstr_cache)) {
+        if(cache_idx < THREAD_CACHE_BUCKETS && (thread_cache = get_thread_cache(FALSE))) {
+            ret = cache_entry_pop(thread_cache + cache_idx);
+            if(!ret && cache_idx+1 < THREAD_CACHE_BUCKETS)
+                ret = cache_entry_pop(thread_cache + cache_idx + 1);
         }
 
-        LeaveCriticalSection(&cs_bstr_cache);
+        /* an unlocked peek is enough to skip empty buckets, they are checked again below */
+        if(!ret && (bstr_cache[cache_idx].cnt ||
+                    (cache_idx+1 < ARRAY_SIZE(bstr_cache) && bstr_cache[cache_idx+1].cnt))) {
+            EnterCriticalSection(&cs_bstr_cache);
+            ret = cache_entry_pop(bstr_cache + cache_idx);
+            if(!ret && cache_idx+1 < ARRAY_SIZE(bstr_cache))
+                ret = cache_entry_pop(bstr_cache + cache_idx + 1);
+            LeaveCriticalSection(&cs_bstr_cache);
+        }
 
-        if(cache_entry) {
+        if(ret) {
             if(WARN_ON(heap)) {
                 size_t fill_size = (FIELD_OFFSET(bstr_t, u.ptr[size])+2*sizeof(WCHAR)-1) & ~(sizeof(WCHAR)-1);
                 memset(ret, ARENA_INUSE_FILLER, fill_size);
@@ -255,6 +315,14 @@ static inline IMalloc *get_malloc(void)
     return malloc;
 }
 
+static void fill_free_bstr(bstr_t *bstr, SIZE_T alloc_size)
+{
+    unsigned i, n = (alloc_size-FIELD_OFFSET(bstr_t, u.ptr))/sizeof(DWORD);
+
+    for(i=0; i<n; i++)
+        bstr->u.dwptr[i] = ARENA_FREE_FILLER;
+}
+
 /******************************************************************************
  *		SysFreeString	[OLEAUT32.6]
  *
@@ -272,10 +340,12 @@ static inline IMalloc *get_malloc(void)
  */
 void WINAPI DECLSPEC_HOTPATCH SysFreeString(BSTR str)
 {
-    bstr_cache_entry_t *cache_entry;
+    bstr_cache_entry_t *thread_cache;
+    unsigned cache_idx;
     bstr_t *bstr;
     IMalloc *malloc = get_malloc();
     SIZE_T alloc_size;
+    BOOL cached;
 
     if(!str)
         return;
@@ -286,37 +356,47 @@ void WINAPI DECLSPEC_HOTPATCH SysFreeString(BSTR str)
     if (alloc_size == ~0UL)
         return;
 
-    cache_entry = get_cache_entry_from_alloc_size(alloc_size);
-    if(cache_entry) {
-        unsigned i;
-
-        EnterCriticalSection(&cs_bstr_cache);
-
+    cache_idx = (alloc_size - BUCKET_SIZE) / BUCKET_SIZE;
+    if(alloc_size >= BUCKET_SIZE && bstr_cache_enabled && cache_idx < ARRAY_SIZE(bstr_cache)) {
         /* According to tests, freeing a string that's already in cache doesn't corrupt anything.
          * For that to work we need to search the cache. */
-        for(i=0; i < cache_entry->cnt; i++) {
-            if(cache_entry->buf[(cache_entry->head+i) % BUCKET_BUFFER_SIZE] == bstr) {
+        if(cache_idx < THREAD_CACHE_BUCKETS && (thread_cache = get_thread_cache(TRUE))) {
+            if(cache_entry_contains(thread_cache + cache_idx, bstr)) {
                 WARN_(heap)("String already is in cache!\n");
+                return;
+            }
+            /* it may also have been freed on another thread and ended up in the global cache */
+            if(bstr_cache[cache_idx].cnt) {
+                EnterCriticalSection(&cs_bstr_cache);
+                cached = cache_entry_contains(bstr_cache + cache_idx, bstr);
                 LeaveCriticalSection(&cs_bstr_cache);
+                if(cached) {
+                    WARN_(heap)("String already is in cache!\n");
+                    return;
+                }
+            }
+            if(cache_entry_push(thread_cache + cache_idx, bstr)) {
+                if(WARN_ON(heap))
+                    fill_free_bstr(bstr, alloc_size);
                 return;
             }
         }
 
-        if(cache_entry->cnt < ARRAY_SIZE(cache_entry->buf)) {
-            cache_entry->buf[(cache_entry->head+cache_entry->cnt) % BUCKET_BUFFER_SIZE] = bstr;
-            cache_entry->cnt++;
-
-            if(WARN_ON(heap)) {
-                unsigned n = (alloc_size-FIELD_OFFSET(bstr_t, u.ptr))/sizeof(DWORD);
-                for(i=0; i<n; i++)
-                    bstr->u.dwptr[i] = ARENA_FREE_FILLER;
-            }
+        EnterCriticalSection(&cs_bstr_cache);
 
+        if(cache_entry_contains(bstr_cache + cache_idx, bstr)) {
+            WARN_(heap)("String already is in cache!\n");
             LeaveCriticalSection(&cs_bstr_cache);
             return;
         }
 
+        cached = cache_entry_push(bstr_cache + cache_idx, bstr);
+        if(cached && WARN_ON(heap))
+            fill_free_bstr(bstr, alloc_size);
+
         LeaveCriticalSection(&cs_bstr_cache);
+        if(cached)
+            return;
     }
 
     CoTaskMemFree(bstr);
@@ -1197,8 +1277,18 @@ HRESULT WINAPI DllGetClassObject(REFCLSID rclsid, REFIID iid, LPVOID *ppv)
  */
 BOOL WINAPI DllMain(HINSTANCE hInstDll, DWORD fdwReason, LPVOID lpvReserved)
 {
-    if(fdwReason == DLL_PROCESS_ATTACH)
+    switch(fdwReason)
+    {
+    case DLL_PROCESS_ATTACH:
         bstr_cache_enabled = !GetEnvironmentVariableW(L"oanocache", NULL, 0);
+        if(bstr_cache_enabled)
+            bstr_cache_fls = FlsAlloc(free_thread_cache);
+        break;
+    case DLL_PROCESS_DETACH:
+        if(!lpvReserved && bstr_cache_fls != FLS_OUT_OF_INDEXES)
+            FlsFree(bstr_cache_fls);
+        break;
+    }
 
     return OLEAUTPS_DllMain( hInstDll, fdwReason, lpvReserved );
 }
@@ -6090,6 +6090,16 @@ static void test_bstr_cache(void)
     pSysFreeString(str2);
     SysFreeString(str);
     SysFreeString(str2);
+
+    /* A string freed twice on the same thread is only handed out once */
+    str = SysAllocStringLen(NULL, 40);
+    pSysFreeString(str);
+    pSysFreeString(str);
+    str = SysAllocStringLen(NULL, 40);
+    str2 = SysAllocStringLen(NULL, 40);
+    ok(str != str2, "got the same string twice\n");
+    SysFreeString(str);
+    SysFreeString(str2);
 }
 
 static void write_typelib(int res_no, const char *filename)
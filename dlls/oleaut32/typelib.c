@@ -1102,10 +1102,13 @@ typedef struct tagITypeLibImpl
     HREFTYPE dispatch_href;     /* reference to IDispatch, -1 if unused */
 
 
-    /* typelibs are cached, keyed by path and index, so store the linked list info within them */
+    /* typelibs are cached, keyed by file identity (or path if unknown) and index,
+     * so store the linked list info within them */
     struct list entry;
     WCHAR *path;
     INT index;
+    BOOL has_file_info;
+    BY_HANDLE_FILE_INFORMATION file_info;
 } ITypeLibImpl;
 
 static const ITypeLib2Vtbl tlbvt;
@@ -1277,6 +1280,12 @@ typedef struct tagTLBContext
 	void *mapping;        /* memory mapping */
 	MSFT_SegDir * pTblDir;
 	ITypeLibImpl* pLibInfo;
+	TLBString **names;    /* name table entries, sorted by offset */
+	UINT name_count;
+	TLBString **strings;  /* string table entries, sorted by offset */
+	UINT string_count;
+	TLBGuid **guids;      /* guid table entries, indexed by offset */
+	UINT guid_count;
 } TLBContext;
 
 
@@ -2074,6 +2083,11 @@ static HRESULT MSFT_ReadAllGuids(TLBContext *pcx)
     MSFT_GuidEntry entry;
     int offs = 0;
 
+    if (pcx->pTblDir->pGuidTab.length > 0 &&
+        !(pcx->guids = malloc((pcx->pTblDir->pGuidTab.length + sizeof(MSFT_GuidEntry) - 1) /
+                              sizeof(MSFT_GuidEntry) * sizeof(*pcx->guids))))
+        return E_OUTOFMEMORY;
+
     MSFT_Seek(pcx, pcx->pTblDir->pGuidTab.offset);
     while (1) {
         if (offs >= pcx->pTblDir->pGuidTab.length)
@@ -2088,6 +2102,7 @@ static HRESULT MSFT_ReadAllGuids(TLBContext *pcx)
         guid->hreftype = entry.hreftype;
 
         list_add_tail(&pcx->pLibInfo->guid_list, &guid->entry);
+        pcx->guids[pcx->guid_count++] = guid;
 
         offs += sizeof(MSFT_GuidEntry);
     }
@@ -2097,14 +2112,14 @@ static TLBGuid *MSFT_ReadGuid( int offset, TLBContext *pcx)
 {
     TLBGuid *ret;
 
-    LIST_FOR_EACH_ENTRY(ret, &pcx->pLibInfo->guid_list, TLBGuid, entry){
-        if(ret->offset == offset){
-            TRACE_(typelib)("%s\n", debugstr_guid(&ret->guid));
-            return ret;
-        }
-    }
+    /* guid table entries have a fixed size */
+    if (offset < 0 || offset % sizeof(MSFT_GuidEntry) ||
+        offset / sizeof(MSFT_GuidEntry) >= pcx->guid_count)
+        return NULL;
 
-    return NULL;
+    ret = pcx->guids[offset / sizeof(MSFT_GuidEntry)];
+    TRACE_(typelib)("%s\n", debugstr_guid(&ret->guid));
+    return ret;
 }
 
 static HREFTYPE MSFT_ReadHreftype( TLBContext *pcx, int offset )
@@ -2130,6 +2145,11 @@ static HRESULT MSFT_ReadAllNames(TLBContext *pcx)
     INT16 len_piece;
     int offs = 0, lengthInChars;
 
+    /* each entry takes at least 8 bytes */
+    if (pcx->pTblDir->pNametab.length > 0 &&
+        !(pcx->names = malloc((pcx->pTblDir->pNametab.length + 7) / 8 * sizeof(*pcx->names))))
+        return E_OUTOFMEMORY;
+
     MSFT_Seek(pcx, pcx->pTblDir->pNametab.offset);
     while (1) {
         TLBString *tlbstr;
@@ -2165,37 +2185,46 @@ static HRESULT MSFT_ReadAllNames(TLBContext *pcx)
         free(string);
 
         list_add_tail(&pcx->pLibInfo->name_list, &tlbstr->entry);
+        pcx->names[pcx->name_count++] = tlbstr;
 
         offs += len_piece;
     }
 }
 
-static TLBString *MSFT_ReadName( TLBContext *pcx, int offset)
+/* entries are read in table order, so the array is sorted by offset */
+static TLBString *MSFT_FindString( TLBString **strs, UINT count, int offset )
 {
-    TLBString *tlbstr;
+    UINT low = 0, high = count;
 
-    LIST_FOR_EACH_ENTRY(tlbstr, &pcx->pLibInfo->name_list, TLBString, entry) {
-        if (tlbstr->offset == offset) {
-            TRACE_(typelib)("%s\n", debugstr_w(tlbstr->str));
-            return tlbstr;
+    if (offset < 0)
+        return NULL;
+
+    while (low < high)
+    {
+        UINT mid = (low + high) / 2;
+
+        if (strs[mid]->offset == (UINT)offset)
+        {
+            TRACE_(typelib)("%s\n", debugstr_w(strs[mid]->str));
+            return strs[mid];
         }
+        if (strs[mid]->offset < (UINT)offset)
+            low = mid + 1;
+        else
+            high = mid;
     }
 
     return NULL;
 }
 
-static TLBString *MSFT_ReadString( TLBContext *pcx, int offset)
+static TLBString *MSFT_ReadName( TLBContext *pcx, int offset)
 {
-    TLBString *tlbstr;
-
-    LIST_FOR_EACH_ENTRY(tlbstr, &pcx->pLibInfo->string_list, TLBString, entry) {
-        if (tlbstr->offset == offset) {
-            TRACE_(typelib)("%s\n", debugstr_w(tlbstr->str));
-            return tlbstr;
-        }
-    }
+    return MSFT_FindString(pcx->names, pcx->name_count, offset);
+}
 
-    return NULL;
+static TLBString *MSFT_ReadString( TLBContext *pcx, int offset)
+{
+    return MSFT_FindString(pcx->strings, pcx->string_count, offset);
 }
 
 /*
@@ -2762,6 +2791,11 @@ static HRESULT MSFT_ReadAllStrings(TLBContext *pcx)
     INT16 len_str, len_piece;
     int offs = 0, lengthInChars;
 
+    /* each entry takes at least 8 bytes */
+    if (pcx->pTblDir->pStringtab.length > 0 &&
+        !(pcx->strings = malloc((pcx->pTblDir->pStringtab.length + 7) / 8 * sizeof(*pcx->strings))))
+        return E_OUTOFMEMORY;
+
     MSFT_Seek(pcx, pcx->pTblDir->pStringtab.offset);
     while (1) {
         TLBString *tlbstr;
@@ -2796,6 +2830,7 @@ static HRESULT MSFT_ReadAllStrings(TLBContext *pcx)
         free(string);
 
         list_add_tail(&pcx->pLibInfo->string_list, &tlbstr->entry);
+        pcx->strings[pcx->string_count++] = tlbstr;
 
         offs += len_piece;
     }
@@ -2856,6 +2891,33 @@ static CRITICAL_SECTION_DEBUG cache_section_debug =
 };
 static CRITICAL_SECTION cache_section = { &cache_section_debug, -1, 0, 0, 0, 0 };
 
+/* must be called with cache_section held */
+static ITypeLibImpl *find_cached_typelib(const WCHAR *path, INT index, const BY_HANDLE_FILE_INFORMATION *info)
+{
+    ITypeLibImpl *entry;
+
+    LIST_FOR_EACH_ENTRY(entry, &tlb_cache, ITypeLibImpl, entry)
+    {
+        if (entry->index != index)
+            continue;
+
+        /* the same file may be reached through different paths, and a path
+         * may point to a different file once the typelib has been replaced */
+        if (info && entry->has_file_info)
+        {
+            if (entry->file_info.dwVolumeSerialNumber == info->dwVolumeSerialNumber
+                    && entry->file_info.nFileIndexHigh == info->nFileIndexHigh
+                    && entry->file_info.nFileIndexLow == info->nFileIndexLow
+                    && !CompareFileTime(&entry->file_info.ftLastWriteTime, &info->ftLastWriteTime))
+                return entry;
+        }
+        else if (!wcsicmp(entry->path, path))
+            return entry;
+    }
+
+    return NULL;
+}
+
 
 typedef struct TLB_PEFile
 {
@@ -3288,6 +3350,8 @@ static HRESULT TLB_ReadTypeLib(LPCWSTR pszFileName, LPWSTR pszPath, UINT cchPath
     LPVOID pBase = NULL;
     DWORD dwTLBLength = 0;
     IUnknown *pFile = NULL;
+    BY_HANDLE_FILE_INFORMATION file_info;
+    BOOL has_file_info = FALSE;
     HANDLE h;
 
     *ppTypeLib = NULL;
@@ -3326,23 +3390,21 @@ static HRESULT TLB_ReadTypeLib(LPCWSTR pszFileName, LPWSTR pszPath, UINT cchPath
     h = CreateFileW(pszPath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
     if(h != INVALID_HANDLE_VALUE){
         GetFinalPathNameByHandleW(h, pszPath, cchPath, FILE_NAME_NORMALIZED | VOLUME_NAME_DOS);
+        has_file_info = GetFileInformationByHandle(h, &file_info);
         CloseHandle(h);
     }
 
     TRACE_(typelib)("File %s index %d\n", debugstr_w(pszPath), index);
 
-    /* We look the path up in the typelib cache. If found, we just addref it, and return the pointer. */
+    /* We look the file up in the typelib cache. If found, we just addref it, and return the pointer. */
     EnterCriticalSection(&cache_section);
-    LIST_FOR_EACH_ENTRY(entry, &tlb_cache, ITypeLibImpl, entry)
+    if ((entry = find_cached_typelib(pszPath, index, has_file_info ? &file_info : NULL)))
     {
-        if (!wcsicmp(entry->path, pszPath) && entry->index == index)
-        {
-            TRACE("cache hit\n");
-            *ppTypeLib = &entry->ITypeLib2_iface;
-            ITypeLib2_AddRef(*ppTypeLib);
-            LeaveCriticalSection(&cache_section);
-            return S_OK;
-        }
+        TRACE("cache hit\n");
+        *ppTypeLib = &entry->ITypeLib2_iface;
+        ITypeLib2_AddRef(*ppTypeLib);
+        LeaveCriticalSection(&cache_section);
+        return S_OK;
     }
     LeaveCriticalSection(&cache_section);
 
@@ -3380,11 +3442,23 @@ static HRESULT TLB_ReadTypeLib(LPCWSTR pszFileName, LPWSTR pszPath, UINT cchPath
 	impl->path = wcsdup(pszPath);
 	/* We should really canonicalise the path here. */
         impl->index = index;
+        impl->has_file_info = has_file_info;
+        if (has_file_info) impl->file_info = file_info;
 
-        /* FIXME: check if it has added already in the meantime */
         EnterCriticalSection(&cache_section);
-        list_add_head(&tlb_cache, &impl->entry);
-        LeaveCriticalSection(&cache_section);
+        if ((entry = find_cached_typelib(pszPath, index, has_file_info ? &file_info : NULL)))
+        {
+            /* another thread loaded it in the meantime */
+            ITypeLib2_AddRef(&entry->ITypeLib2_iface);
+            LeaveCriticalSection(&cache_section);
+            ITypeLib2_Release(*ppTypeLib);
+            *ppTypeLib = &entry->ITypeLib2_iface;
+        }
+        else
+        {
+            list_add_head(&tlb_cache, &impl->entry);
+            LeaveCriticalSection(&cache_section);
+        }
         ret = S_OK;
     }
     else
@@ -3449,6 +3523,9 @@ static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength)
     cx.mapping = pLib;
     cx.pLibInfo = pTypeLibImpl;
     cx.length = dwTLBLength;
+    cx.names = cx.strings = NULL;
+    cx.guids = NULL;
+    cx.name_count = cx.string_count = cx.guid_count = 0;
 
     /* read header */
     MSFT_ReadLEDWords(&tlbHeader, sizeof(tlbHeader), &cx, 0);
@@ -3478,9 +3555,18 @@ static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength)
 	return NULL;
     }
 
-    MSFT_ReadAllNames(&cx);
-    MSFT_ReadAllStrings(&cx);
-    MSFT_ReadAllGuids(&cx);
+    /* Malformed names are skipped as before, but without the lookup arrays
+     * every name, string and guid reference would resolve to NULL. */
+    if (MSFT_ReadAllNames(&cx) == E_OUTOFMEMORY || MSFT_ReadAllStrings(&cx) == E_OUTOFMEMORY
+            || MSFT_ReadAllGuids(&cx) == E_OUTOFMEMORY)
+    {
+        ERR("out of memory reading the name, string and guid tables\n");
+        free(cx.names);
+        free(cx.strings);
+        free(cx.guids);
+        ITypeLib2_Release(&pTypeLibImpl->ITypeLib2_iface);
+        return NULL;
+    }
 
     /* now fill our internal data */
     /* TLIBATTR fields */
@@ -3640,6 +3726,10 @@ static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength)
             TLB_fix_typeinfo_ptr_size(pTypeLibImpl->typeinfos[i]);
     }
 
+    free(cx.names);
+    free(cx.strings);
+    free(cx.guids);
+
     TRACE("(%p)\n", pTypeLibImpl);
     return &pTypeLibImpl->ITypeLib2_iface;
 }
@@ -68,6 +68,16 @@ typedef struct _RpcConnection_np
     IO_STATUS_BLOCK io_status;
     HANDLE event_cache;
     BOOL read_closed;
+    /* ncalrpc shared memory transport */
+    char *shm_advert_name;
+    HANDLE shm_advert;
+    BOOL shm_checked;
+    struct lrpc_shm *shm;
+    HANDLE shm_section;
+    HANDLE shm_peer_event;
+    HANDLE shm_wait[3]; /* own event, peer process, cancel event */
+    ULONG shm_read_pos;  /* own ring positions, the shared copies */
+    ULONG shm_write_pos; /* can be modified by the peer */
 } RpcConnection_np;
 
 static RpcConnection *rpcrt4_conn_np_alloc(void)
@@ -108,6 +118,10 @@ static RPC_STATUS rpcrt4_conn_create_pipe(RpcConnection *conn)
             return RPC_S_CANT_CREATE_ENDPOINT;
     }
 
+    /* let clients know that they can switch to shared memory */
+    if (connection->shm_advert_name && !connection->shm_advert)
+        connection->shm_advert = CreateEventA(NULL, TRUE, FALSE, connection->shm_advert_name);
+
     return RPC_S_OK;
 }
 
@@ -185,6 +199,17 @@ static char *ncalrpc_pipe_name(const char *endpoint)
   return pipe_name;
 }
 
+static char *ncalrpc_shm_advert_name(const char *endpoint)
+{
+  static const char prefix[] = "WineLrpcShm.";
+  char *name, *p;
+
+  name = I_RpcAllocate(sizeof(prefix) + strlen(endpoint));
+  strcat(strcpy(name, prefix), endpoint);
+  for (p = name; *p; p++) if (*p == '\\') *p = '_';
+  return name;
+}
+
 static RPC_STATUS rpcrt4_ncalrpc_open(RpcConnection* Connection)
 {
   RpcConnection_np *npc = (RpcConnection_np *) Connection;
@@ -224,6 +249,7 @@ static RPC_STATUS rpcrt4_protseq_ncalrpc_open_endpoint(RpcServerProtseq* protseq
       return r;
 
   ((RpcConnection_np*)Connection)->listen_pipe = ncalrpc_pipe_name(Connection->Endpoint);
+  ((RpcConnection_np*)Connection)->shm_advert_name = ncalrpc_shm_advert_name(Connection->Endpoint);
   r = rpcrt4_conn_create_pipe(Connection);
 
   EnterCriticalSection(&protseq->cs);
@@ -445,6 +471,11 @@ static int rpcrt4_conn_np_close(RpcConnection *conn)
         CloseHandle(connection->event_cache);
         connection->event_cache = 0;
     }
+    if (connection->shm_advert)
+    {
+        CloseHandle(connection->shm_advert);
+        connection->shm_advert = 0;
+    }
     return 0;
 }
 
@@ -468,6 +499,395 @@ static int rpcrt4_conn_np_wait_for_incoming_data(RpcConnection *conn)
     return rpcrt4_conn_np_read(conn, NULL, 0);
 }
 
+/* Connections between Wine processes move ncalrpc data through a ring buffer
+ * in shared memory instead of the pipe. The client creates the section and
+ * events, and sends a handshake with their id as its first message if the
+ * server advertises support. The server derives the object names from the
+ * client process id of the pipe, so a client can only attach it to objects
+ * of its own process, and acknowledges the handshake. The pipe stays open for
+ * impersonation and client identification, and is used for everything if the
+ * handshake fails. */
+
+#define LRPC_SHM_MAGIC       0x4d48534c /* "LSHM" */
+#define LRPC_SHM_RING_SIZE   0x10000
+#define LRPC_SHM_DATA_OFFSET 0x1000
+
+struct lrpc_shm_ring
+{
+    LONG read_pos;
+    LONG write_pos;
+};
+
+struct lrpc_shm
+{
+    DWORD magic;
+    DWORD ring_size;
+    LONG waiting[2];                /* indexed by side, 0 is the client */
+    LONG closed[2];
+    struct lrpc_shm_ring ring[2];   /* data sent by the respective side */
+};
+
+struct lrpc_shm_handshake
+{
+    DWORD magic;
+    DWORD ring_size;
+    DWORD id;
+};
+
+static void lrpc_shm_name(char *name, size_t size, DWORD pid, DWORD id)
+{
+    snprintf(name, size, "WineLrpc%08lx.%08lx", pid, id);
+}
+
+static inline unsigned int lrpc_shm_side(const RpcConnection_np *connection)
+{
+    return connection->common.server ? 1 : 0;
+}
+
+static inline char *lrpc_shm_data(struct lrpc_shm *shm, unsigned int side)
+{
+    return (char *)shm + LRPC_SHM_DATA_OFFSET + side * LRPC_SHM_RING_SIZE;
+}
+
+static void lrpc_shm_free(RpcConnection_np *connection)
+{
+    unsigned int i;
+
+    if (connection->shm)
+    {
+        InterlockedExchange(&connection->shm->closed[lrpc_shm_side(connection)], TRUE);
+        if (connection->shm_peer_event) SetEvent(connection->shm_peer_event);
+        UnmapViewOfFile(connection->shm);
+        connection->shm = NULL;
+    }
+    if (connection->shm_section)
+    {
+        CloseHandle(connection->shm_section);
+        connection->shm_section = 0;
+    }
+    if (connection->shm_peer_event)
+    {
+        CloseHandle(connection->shm_peer_event);
+        connection->shm_peer_event = 0;
+    }
+    for (i = 0; i < ARRAY_SIZE(connection->shm_wait); i++)
+    {
+        if (!connection->shm_wait[i]) continue;
+        CloseHandle(connection->shm_wait[i]);
+        connection->shm_wait[i] = 0;
+    }
+}
+
+static BOOL lrpc_shm_open_objects(RpcConnection_np *connection, const char *name, BOOL create, DWORD peer_pid)
+{
+    unsigned int side = lrpc_shm_side(connection);
+    char event_name[40];
+    void *shm;
+
+    /* the creator must not pick up objects someone else created in advance */
+    if (create)
+        connection->shm_section = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0,
+                                                     LRPC_SHM_DATA_OFFSET + 2 * LRPC_SHM_RING_SIZE, name);
+    else
+        connection->shm_section = OpenFileMappingA(FILE_MAP_READ | FILE_MAP_WRITE, FALSE, name);
+    if (!connection->shm_section || (create && GetLastError() == ERROR_ALREADY_EXISTS))
+        return FALSE;
+    if (!(shm = MapViewOfFile(connection->shm_section, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0,
+                              LRPC_SHM_DATA_OFFSET + 2 * LRPC_SHM_RING_SIZE)))
+        return FALSE;
+    connection->shm = shm;
+    connection->shm_read_pos = 0;
+    connection->shm_write_pos = 0;
+
+    snprintf(event_name, sizeof(event_name), "%s.%c", name, side ? 's' : 'c');
+    connection->shm_wait[0] = create ? CreateEventA(NULL, FALSE, FALSE, event_name)
+                                     : OpenEventA(EVENT_MODIFY_STATE | SYNCHRONIZE, FALSE, event_name);
+    if (!connection->shm_wait[0] || (create && GetLastError() == ERROR_ALREADY_EXISTS))
+        return FALSE;
+    snprintf(event_name, sizeof(event_name), "%s.%c", name, side ? 'c' : 's');
+    connection->shm_peer_event = create ? CreateEventA(NULL, FALSE, FALSE, event_name)
+                                        : OpenEventA(EVENT_MODIFY_STATE | SYNCHRONIZE, FALSE, event_name);
+    if (!connection->shm_peer_event || (create && GetLastError() == ERROR_ALREADY_EXISTS))
+        return FALSE;
+    connection->shm_wait[1] = OpenProcess(SYNCHRONIZE, FALSE, peer_pid);
+    connection->shm_wait[2] = CreateEventW(NULL, FALSE, FALSE, NULL);
+
+    return connection->shm_wait[1] && connection->shm_wait[2];
+}
+
+/* client side, called before the first write */
+static RPC_STATUS lrpc_shm_connect(RpcConnection_np *connection)
+{
+    static LONG lrpc_shm_id;
+    struct lrpc_shm_handshake handshake;
+    char *advert_name, name[32];
+    HANDLE advert;
+    DWORD pid, status;
+
+    connection->shm_checked = TRUE;
+
+    advert_name = ncalrpc_shm_advert_name(connection->common.Endpoint);
+    advert = OpenEventA(SYNCHRONIZE, FALSE, advert_name);
+    I_RpcFree(advert_name);
+    if (!advert)
+        return RPC_S_OK;
+    CloseHandle(advert);
+
+    if (!GetNamedPipeServerProcessId(connection->pipe, &pid))
+        return RPC_S_OK;
+
+    handshake.magic = LRPC_SHM_MAGIC;
+    handshake.ring_size = LRPC_SHM_RING_SIZE;
+    handshake.id = InterlockedIncrement(&lrpc_shm_id);
+    lrpc_shm_name(name, sizeof(name), GetCurrentProcessId(), handshake.id);
+    if (!lrpc_shm_open_objects(connection, name, TRUE, pid))
+    {
+        WARN("failed to create shared memory for %s\n", connection->common.Endpoint);
+        lrpc_shm_free(connection);
+        return RPC_S_OK;
+    }
+    connection->shm->magic = LRPC_SHM_MAGIC;
+    connection->shm->ring_size = LRPC_SHM_RING_SIZE;
+
+    if (rpcrt4_conn_np_write(&connection->common, &handshake, sizeof(handshake)) != sizeof(handshake) ||
+        rpcrt4_conn_np_read(&connection->common, &status, sizeof(status)) != sizeof(status))
+    {
+        lrpc_shm_free(connection);
+        return RPC_S_CALL_FAILED;
+    }
+
+    if (status != RPC_S_OK)
+    {
+        WARN("server refused shared memory, status %lu\n", status);
+        lrpc_shm_free(connection);
+        return RPC_S_OK;
+    }
+
+    TRACE("using shared memory %s for %s\n", name, connection->common.Endpoint);
+    return RPC_S_OK;
+}
+
+/* server side, called before the first read */
+static int lrpc_shm_accept(RpcConnection_np *connection)
+{
+    struct lrpc_shm_handshake handshake;
+    DWORD count, left, pid, status = RPC_S_OUT_OF_RESOURCES;
+    char name[32] = "";
+
+    connection->shm_checked = TRUE;
+
+    /* wait for the first message and check whether it is a handshake */
+    if (rpcrt4_conn_np_read(&connection->common, NULL, 0) == -1)
+        return -1;
+    if (!PeekNamedPipe(connection->pipe, &handshake, sizeof(handshake), &count, NULL, &left) ||
+        count != sizeof(handshake) || left || handshake.magic != LRPC_SHM_MAGIC)
+        return 0;
+    if (rpcrt4_conn_np_read(&connection->common, &handshake, sizeof(handshake)) != sizeof(handshake))
+        return -1;
+
+    if (handshake.ring_size == LRPC_SHM_RING_SIZE && GetNamedPipeClientProcessId(connection->pipe, &pid))
+    {
+        lrpc_shm_name(name, sizeof(name), pid, handshake.id);
+        if (lrpc_shm_open_objects(connection, name, FALSE, pid) &&
+            connection->shm->magic == LRPC_SHM_MAGIC && connection->shm->ring_size == LRPC_SHM_RING_SIZE)
+            status = RPC_S_OK;
+    }
+    if (status != RPC_S_OK)
+    {
+        WARN("failed to attach to shared memory %s\n", debugstr_a(name));
+        lrpc_shm_free(connection);
+    }
+
+    if (rpcrt4_conn_np_write(&connection->common, &status, sizeof(status)) != sizeof(status))
+    {
+        lrpc_shm_free(connection);
+        return -1;
+    }
+
+    TRACE("using shared memory %s, status %lu\n", debugstr_a(name), status);
+    return 0;
+}
+
+static void lrpc_shm_wake_peer(RpcConnection_np *connection)
+{
+    if (InterlockedExchange(&connection->shm->waiting[!lrpc_shm_side(connection)], FALSE))
+        SetEvent(connection->shm_peer_event);
+}
+
+/* The peer can write anything to the shared ring positions, so they are only
+ * used to publish our own position and are checked against our private copy
+ * when reading the peer's one. These return -1 for an invalid position. */
+static LONG lrpc_shm_avail(RpcConnection_np *connection)
+{
+    struct lrpc_shm_ring *ring = &connection->shm->ring[!lrpc_shm_side(connection)];
+    ULONG avail = ReadAcquire(&ring->write_pos) - connection->shm_read_pos;
+
+    return avail > LRPC_SHM_RING_SIZE ? -1 : avail;
+}
+
+static LONG lrpc_shm_space(RpcConnection_np *connection)
+{
+    struct lrpc_shm_ring *ring = &connection->shm->ring[lrpc_shm_side(connection)];
+    ULONG used = connection->shm_write_pos - ReadAcquire(&ring->read_pos);
+
+    return used > LRPC_SHM_RING_SIZE ? -1 : LRPC_SHM_RING_SIZE - used;
+}
+
+/* waits until the incoming ring has data or the outgoing one has space */
+static BOOL lrpc_shm_wait(RpcConnection_np *connection, BOOL incoming)
+{
+    unsigned int side = lrpc_shm_side(connection);
+    struct lrpc_shm *shm = connection->shm;
+
+    /* like CancelIoEx on the pipe, a cancel only aborts a wait in progress;
+     * read_closed is checked below, so dropping an earlier signal is safe */
+    ResetEvent(connection->shm_wait[2]);
+    InterlockedExchange(&shm->waiting[side], TRUE);
+
+    /* check again now that the peer can see we are waiting, invalid positions
+     * are reported by the caller */
+    if (incoming ? lrpc_shm_avail(connection) : lrpc_shm_space(connection))
+        return TRUE;
+    if (connection->read_closed || ReadAcquire(&shm->closed[!side]))
+        return FALSE;
+
+    return WaitForMultipleObjects(ARRAY_SIZE(connection->shm_wait), connection->shm_wait,
+                                  FALSE, INFINITE) == WAIT_OBJECT_0;
+}
+
+static int lrpc_shm_read(RpcConnection_np *connection, void *buffer, unsigned int count)
+{
+    unsigned int side = lrpc_shm_side(connection);
+    struct lrpc_shm_ring *ring = &connection->shm->ring[!side];
+    const char *data = lrpc_shm_data(connection->shm, !side);
+    unsigned int done = 0;
+
+    while (done < count)
+    {
+        ULONG pos = connection->shm_read_pos, offset = pos % LRPC_SHM_RING_SIZE, len, first;
+        LONG avail = lrpc_shm_avail(connection);
+
+        if (avail == -1)
+        {
+            WARN("invalid write position from peer\n");
+            return -1;
+        }
+        if (!avail)
+        {
+            if (!lrpc_shm_wait(connection, TRUE)) return -1;
+            continue;
+        }
+
+        len = min(avail, count - done);
+        first = min(len, LRPC_SHM_RING_SIZE - offset);
+        memcpy((char *)buffer + done, data + offset, first);
+        memcpy((char *)buffer + done + first, data, len - first);
+        connection->shm_read_pos = pos + len;
+        InterlockedExchange(&ring->read_pos, pos + len);
+        lrpc_shm_wake_peer(connection);
+        done += len;
+    }
+    return done;
+}
+
+static int lrpc_shm_write(RpcConnection_np *connection, const void *buffer, unsigned int count)
+{
+    unsigned int side = lrpc_shm_side(connection);
+    struct lrpc_shm_ring *ring = &connection->shm->ring[side];
+    char *data = lrpc_shm_data(connection->shm, side);
+    unsigned int done = 0;
+
+    while (done < count)
+    {
+        ULONG pos = connection->shm_write_pos, offset = pos % LRPC_SHM_RING_SIZE, len, first;
+        LONG space = lrpc_shm_space(connection);
+
+        if (ReadAcquire(&connection->shm->closed[!side]))
+            return -1;
+        if (space == -1)
+        {
+            WARN("invalid read position from peer\n");
+            return -1;
+        }
+        if (!space)
+        {
+            if (!lrpc_shm_wait(connection, FALSE)) return -1;
+            continue;
+        }
+
+        len = min(space, count - done);
+        first = min(len, LRPC_SHM_RING_SIZE - offset);
+        memcpy(data + offset, (const char *)buffer + done, first);
+        memcpy(data, (const char *)buffer + done + first, len - first);
+        connection->shm_write_pos = pos + len;
+        InterlockedExchange(&ring->write_pos, pos + len);
+        lrpc_shm_wake_peer(connection);
+        done += len;
+    }
+    return done;
+}
+
+static int rpcrt4_ncalrpc_read(RpcConnection *conn, void *buffer, unsigned int count)
+{
+    RpcConnection_np *connection = (RpcConnection_np *)conn;
+
+    if (conn->server && !connection->shm_checked && lrpc_shm_accept(connection) == -1)
+        return -1;
+    if (connection->shm)
+        return lrpc_shm_read(connection, buffer, count);
+    return rpcrt4_conn_np_read(conn, buffer, count);
+}
+
+static int rpcrt4_ncalrpc_write(RpcConnection *conn, const void *buffer, unsigned int count)
+{
+    RpcConnection_np *connection = (RpcConnection_np *)conn;
+
+    if (!conn->server && !connection->shm_checked && lrpc_shm_connect(connection) != RPC_S_OK)
+        return -1;
+    if (connection->shm)
+        return lrpc_shm_write(connection, buffer, count);
+    return rpcrt4_conn_np_write(conn, buffer, count);
+}
+
+static int rpcrt4_ncalrpc_close(RpcConnection *conn)
+{
+    lrpc_shm_free((RpcConnection_np *)conn);
+    return rpcrt4_conn_np_close(conn);
+}
+
+static void rpcrt4_ncalrpc_close_read(RpcConnection *conn)
+{
+    RpcConnection_np *connection = (RpcConnection_np *)conn;
+
+    rpcrt4_conn_np_close_read(conn);
+    if (connection->shm)
+        SetEvent(connection->shm_wait[2]);
+}
+
+static void rpcrt4_ncalrpc_cancel_call(RpcConnection *conn)
+{
+    RpcConnection_np *connection = (RpcConnection_np *)conn;
+
+    rpcrt4_conn_np_cancel_call(conn);
+    if (connection->shm)
+        SetEvent(connection->shm_wait[2]);
+}
+
+static int rpcrt4_ncalrpc_wait_for_incoming_data(RpcConnection *conn)
+{
+    RpcConnection_np *connection = (RpcConnection_np *)conn;
+    LONG avail;
+
+    if (conn->server && !connection->shm_checked && lrpc_shm_accept(connection) == -1)
+        return -1;
+    if (!connection->shm)
+        return rpcrt4_conn_np_wait_for_incoming_data(conn);
+
+    while (!(avail = lrpc_shm_avail(connection)))
+        if (!lrpc_shm_wait(connection, TRUE)) return -1;
+    return avail == -1 ? -1 : 0;
+}
+
 static size_t rpcrt4_ncacn_np_get_top_of_tower(unsigned char *tower_data,
                                                const char *networkaddr,
                                                const char *endpoint)
@@ -3145,13 +3565,13 @@ static const struct connection_ops conn_protseq_list[] = {
     rpcrt4_conn_np_alloc,
     rpcrt4_ncalrpc_open,
     rpcrt4_ncalrpc_handoff,
-    rpcrt4_conn_np_read,
-    rpcrt4_conn_np_write,
-    rpcrt4_conn_np_close,
-    rpcrt4_conn_np_close_read,
-    rpcrt4_conn_np_cancel_call,
+    rpcrt4_ncalrpc_read,
+    rpcrt4_ncalrpc_write,
+    rpcrt4_ncalrpc_close,
+    rpcrt4_ncalrpc_close_read,
+    rpcrt4_ncalrpc_cancel_call,
     rpcrt4_ncalrpc_np_is_server_listening,
-    rpcrt4_conn_np_wait_for_incoming_data,
+    rpcrt4_ncalrpc_wait_for_incoming_data,
     rpcrt4_ncalrpc_get_top_of_tower,
     rpcrt4_ncalrpc_parse_top_of_tower,
     NULL,
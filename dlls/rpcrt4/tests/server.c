@@ -2123,6 +2123,21 @@ run_tests(void)
   test_handle_return();
 }
 
+static void test_large_call(void)
+{
+    /* spans many fragments, and more than the ncalrpc shared memory ring */
+    int i, n = 100000, sum = 0, *x;
+
+    x = malloc(n * sizeof(*x));
+    for (i = 0; i < n; i++)
+    {
+        x[i] = i % 7 - 3;
+        sum += x[i];
+    }
+    ok(sum_conf_array(x, n) == sum, "RPC sum_conf_array\n");
+    free(x);
+}
+
 static void
 set_auth_info(RPC_BINDING_HANDLE handle)
 {
@@ -2206,6 +2221,7 @@ client(const char *test)
     ok(RPC_S_OK == RpcBindingFromStringBindingA(binding, &IMixedServer_IfHandle), "RpcBindingFromStringBinding\n");
 
     run_tests(); /* can cause RPC_X_BAD_STUB_DATA exception */
+    test_large_call();
     authinfo_test(RPC_PROTSEQ_LRPC, 0);
     test_I_RpcBindingInqLocalClientPID(RPC_PROTSEQ_LRPC, IMixedServer_IfHandle);
     test_is_server_listening(IMixedServer_IfHandle, RPC_S_OK);
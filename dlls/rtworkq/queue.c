@@ -127,6 +127,8 @@ enum work_item_type
 
 struct work_item
 {
+    /* Used while the item sits in the free list, must stay first. */
+    SLIST_ENTRY free_entry;
     IUnknown IUnknown_iface;
     LONG refcount;
     struct list entry;
@@ -146,6 +148,9 @@ struct work_item
     } u;
 };
 
+#define WORK_ITEM_CACHE_SIZE 256
+static SLIST_HEADER work_item_cache;
+
 static struct work_item *work_item_impl_from_IUnknown(IUnknown *iface)
 {
     return CONTAINING_RECORD(iface, struct work_item, IUnknown_iface);
@@ -573,7 +578,11 @@ static ULONG WINAPI work_item_Release(IUnknown *iface)
         if (item->reply_result)
             IRtwqAsyncResult_Release(item->reply_result);
         IRtwqAsyncResult_Release(item->result);
-        free(item);
+
+        if (QueryDepthSList(&work_item_cache) < WORK_ITEM_CACHE_SIZE)
+            InterlockedPushEntrySList(&work_item_cache, &item->free_entry);
+        else
+            free(item);
     }
 
     return refcount;
@@ -592,7 +601,12 @@ static struct work_item * alloc_work_item(struct queue *queue, LONG priority, IR
     DWORD flags = 0, queue_id = 0;
     struct work_item *item;
 
-    item = calloc(1, sizeof(*item));
+    if ((item = (struct work_item *)InterlockedPopEntrySList(&work_item_cache)))
+        memset(item, 0, sizeof(*item));
+    else if (!(item = calloc(1, sizeof(*item))))
+    {
+        return NULL;
+    }
 
     item->IUnknown_iface.lpVtbl = &work_item_vtbl;
     item->result = result;
@@ -1214,6 +1228,19 @@ HRESULT WINAPI RtwqStartup(void)
     return S_OK;
 }
 
+static void flush_work_item_cache(void)
+{
+    SLIST_ENTRY *entry, *next;
+
+    entry = InterlockedFlushSList(&work_item_cache);
+    while (entry)
+    {
+        next = entry->Next;
+        free(CONTAINING_RECORD(entry, struct work_item, free_entry));
+        entry = next;
+    }
+}
+
 static void shutdown_system_queues(void)
 {
     unsigned int i;
@@ -1226,6 +1253,8 @@ static void shutdown_system_queues(void)
         shutdown_queue(&system_queues[i]);
     }
 
+    flush_work_item_cache();
+
     if (FAILED(hr = CoDecrementMTAUsage(mta_cookie)))
         WARN("Failed to uninitialize MTA, hr %#lx.\n", hr);
 
@@ -1472,6 +1472,105 @@ static void resolve_labels(compile_ctx_t *ctx, unsigned off)
     ctx->labels_cnt = 0;
 }
 
+/*
+ * Local variables are numbered first, followed by arguments, in the order
+ * lookup_identifier searches them. The function's own name refers to its
+ * return value, so it's never bound to a slot.
+ */
+static BOOL lookup_local_slot(function_t *func, const WCHAR *name, unsigned *ret)
+{
+    unsigned i;
+
+    if((func->type == FUNC_FUNCTION || func->type == FUNC_PROPGET) && !wcsicmp(name, func->name))
+        return FALSE;
+
+    for(i = 0; i < func->var_cnt; i++) {
+        if(!wcsicmp(func->vars[i].name, name)) {
+            *ret = i;
+            return TRUE;
+        }
+    }
+
+    for(i = 0; i < func->arg_cnt; i++) {
+        if(!wcsicmp(func->args[i].name, name)) {
+            *ret = func->var_cnt + i;
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+static BOOL is_local_add(instr_t *instr, const BOOL *is_target)
+{
+    return instr[1].op == OP_int
+        && (instr[2].op == OP_add || instr[2].op == OP_sub)
+        && instr[3].op == OP_assign_local && instr[3].arg1.uint == instr->arg1.uint
+        && !is_target[1] && !is_target[2] && !is_target[3];
+}
+
+/*
+ * Bind references to locals and arguments to their slots, so that they don't
+ * need a name lookup at run time, and fuse "x = x + const" into OP_local_add.
+ */
+static HRESULT resolve_locals(compile_ctx_t *ctx, function_t *func)
+{
+    instr_t *instrs = ctx->code->instrs + func->code_off;
+    unsigned i, slot, cnt = ctx->instr_cnt - func->code_off;
+    BOOL *is_target;
+
+    if(func->type == FUNC_GLOBAL || (!func->var_cnt && !func->arg_cnt))
+        return S_OK;
+
+    for(i = 0; i < cnt; i++) {
+        switch(instrs[i].op) {
+        case OP_ident:
+            if(lookup_local_slot(func, instrs[i].arg1.bstr, &slot)) {
+                instrs[i].op = OP_local;
+                instrs[i].arg1.uint = slot;
+            }
+            break;
+        case OP_assign_ident:
+            if(!instrs[i].arg2.uint && lookup_local_slot(func, instrs[i].arg1.bstr, &slot)) {
+                instrs[i].op = OP_assign_local;
+                instrs[i].arg1.uint = slot;
+            }
+            break;
+        case OP_incc:
+            if(lookup_local_slot(func, instrs[i].arg1.bstr, &slot)) {
+                instrs[i].op = OP_incc_local;
+                instrs[i].arg1.uint = slot;
+            }
+            break;
+        case OP_step:
+            if(lookup_local_slot(func, instrs[i].arg2.bstr, &slot)) {
+                instrs[i].op = OP_step_local;
+                instrs[i].arg2.uint = slot;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    is_target = calloc(cnt, sizeof(*is_target));
+    if(!is_target)
+        return E_OUTOFMEMORY;
+
+    for(i = 0; i < cnt; i++) {
+        if(instr_info[instrs[i].op].arg1_type == ARG_ADDR && instrs[i].arg1.uint - func->code_off < cnt)
+            is_target[instrs[i].arg1.uint - func->code_off] = TRUE;
+    }
+
+    for(i = 0; i + 3 < cnt; i++) {
+        if(instrs[i].op == OP_local && is_local_add(instrs + i, is_target + i))
+            instrs[i].op = OP_local_add;
+    }
+
+    free(is_target);
+    return S_OK;
+}
+
 static HRESULT fill_array_desc(compile_ctx_t *ctx, dim_decl_t *dim_decl, array_desc_t *array_desc)
 {
     unsigned dim_cnt = 0, i;
@@ -1582,7 +1681,7 @@ static HRESULT compile_func(compile_ctx_t *ctx, statement_t *stat, function_t *f
         assert(array_id == func->array_cnt);
     }
 
-    return S_OK;
+    return resolve_locals(ctx, func);
 }
 
 static BOOL lookup_funcs_name(compile_ctx_t *ctx, const WCHAR *name)
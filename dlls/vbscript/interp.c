@@ -126,6 +126,12 @@ static BOOL lookup_global_funcs(ScriptDisp *script, const WCHAR *name, ref_t *re
     return FALSE;
 }
 
+/* Slots are assigned by the compiler, see resolve_locals. */
+static inline VARIANT *local_var(exec_ctx_t *ctx, unsigned slot)
+{
+    return slot < ctx->func->var_cnt ? ctx->vars + slot : ctx->args + (slot - ctx->func->var_cnt);
+}
+
 static HRESULT lookup_identifier(exec_ctx_t *ctx, BSTR name, vbdisp_invoke_type_t invoke_type, ref_t *ref)
 {
     ScriptDisp *script_obj = ctx->script->script_obj;
@@ -809,6 +815,105 @@ static HRESULT interp_ident(exec_ctx_t *ctx)
     return stack_push(ctx, &v);
 }
 
+static HRESULT var_cmp(exec_ctx_t *ctx, VARIANT *l, VARIANT *r)
+{
+    LONG a, b;
+
+    TRACE("%s %s\n", debugstr_variant(l), debugstr_variant(r));
+
+    if((V_VT(l) == VT_I2 || V_VT(l) == VT_I4) && (V_VT(r) == VT_I2 || V_VT(r) == VT_I4)) {
+        a = V_VT(l) == VT_I2 ? V_I2(l) : V_I4(l);
+        b = V_VT(r) == VT_I2 ? V_I2(r) : V_I4(r);
+        return a < b ? VARCMP_LT : a > b ? VARCMP_GT : VARCMP_EQ;
+    }
+
+    /* FIXME: Fix comparing string to number */
+
+    return VarCmp(l, r, ctx->script->lcid, 0);
+}
+
+static HRESULT interp_local(exec_ctx_t *ctx)
+{
+    VARIANT *var = local_var(ctx, ctx->instr->arg1.uint);
+    VARIANT v;
+
+    TRACE("%u\n", ctx->instr->arg1.uint);
+
+    V_VT(&v) = VT_BYREF|VT_VARIANT;
+    V_BYREF(&v) = V_VT(var) == (VT_VARIANT|VT_BYREF) ? V_VARIANTREF(var) : var;
+    return stack_push(ctx, &v);
+}
+
+/*
+ * Integer fast path for VarAdd and VarSub. It only handles the cases where
+ * the result has the same type VarAdd/VarSub would give it without overflow
+ * promotion, everything else is left to oleaut32.
+ */
+static BOOL int_add(VARIANT *l, VARIANT *r, BOOL sub, VARIANT *res)
+{
+    LONG64 val;
+
+    if(V_VT(l) == VT_I2 && V_VT(r) == VT_I2) {
+        val = sub ? (LONG)V_I2(l) - V_I2(r) : (LONG)V_I2(l) + V_I2(r);
+        if(val != (SHORT)val)
+            return FALSE;
+        V_VT(res) = VT_I2;
+        V_I2(res) = val;
+        return TRUE;
+    }
+
+    if((V_VT(l) != VT_I2 && V_VT(l) != VT_I4) || (V_VT(r) != VT_I2 && V_VT(r) != VT_I4))
+        return FALSE;
+
+    val = V_VT(l) == VT_I2 ? V_I2(l) : V_I4(l);
+    if(sub)
+        val -= V_VT(r) == VT_I2 ? V_I2(r) : V_I4(r);
+    else
+        val += V_VT(r) == VT_I2 ? V_I2(r) : V_I4(r);
+    if(val != (LONG)val)
+        return FALSE;
+    V_VT(res) = VT_I4;
+    V_I4(res) = val;
+    return TRUE;
+}
+
+/*
+ * Fused "x = x + const" and "x = x - const" on a local. It stands in for
+ * the OP_local of the sequence; when the fast path doesn't apply, it behaves
+ * like OP_local and the remaining instructions run as usual.
+ */
+static HRESULT interp_local_add(exec_ctx_t *ctx)
+{
+    VARIANT *var = local_var(ctx, ctx->instr->arg1.uint);
+    const LONG arg = ctx->instr[1].arg1.lng;
+    VARIANT c, v;
+    HRESULT hres;
+
+    TRACE("%u %ld\n", ctx->instr->arg1.uint, arg);
+
+    if(V_VT(var) == (VT_VARIANT|VT_BYREF))
+        var = V_VARIANTREF(var);
+
+    if(arg == (INT16)arg) {
+        V_VT(&c) = VT_I2;
+        V_I2(&c) = arg;
+    }else {
+        V_VT(&c) = VT_I4;
+        V_I4(&c) = arg;
+    }
+
+    if(int_add(var, &c, ctx->instr[2].op == OP_sub, &v)) {
+        *var = v;
+        ctx->instr += 4;
+        return S_OK;
+    }
+
+    hres = interp_local(ctx);
+    if(SUCCEEDED(hres))
+        ctx->instr++;
+    return hres;
+}
+
 static HRESULT assign_value(exec_ctx_t *ctx, VARIANT *dst, VARIANT *src, WORD flags)
 {
     VARIANT value;
@@ -944,6 +1049,28 @@ static HRESULT interp_assign_ident(exec_ctx_t *ctx)
     return S_OK;
 }
 
+static HRESULT interp_assign_local(exec_ctx_t *ctx)
+{
+    VARIANT *var = local_var(ctx, ctx->instr->arg1.uint);
+    HRESULT hres;
+
+    TRACE("%u\n", ctx->instr->arg1.uint);
+
+    if(V_VT(var) == (VT_VARIANT|VT_BYREF))
+        var = V_VARIANTREF(var);
+    if(V_VT(var) == (VT_ARRAY|VT_BYREF|VT_VARIANT)) {
+        FIXME("non-array assign\n");
+        return E_NOTIMPL;
+    }
+
+    hres = assign_value(ctx, var, stack_top(ctx, 0), DISPATCH_PROPERTYPUT);
+    if(FAILED(hres))
+        return hres;
+
+    stack_popn(ctx, 1);
+    return S_OK;
+}
+
 static HRESULT interp_set_ident(exec_ctx_t *ctx)
 {
     const BSTR arg = ctx->instr->arg1.bstr;
@@ -1420,34 +1547,21 @@ static HRESULT interp_redim_preserve(exec_ctx_t *ctx)
     return hres;
 }
 
-static HRESULT interp_step(exec_ctx_t *ctx)
+static HRESULT do_step(exec_ctx_t *ctx, VARIANT *var)
 {
-    const BSTR ident = ctx->instr->arg2.bstr;
     BOOL gteq_zero;
     VARIANT zero;
-    ref_t ref;
     HRESULT hres;
 
-    TRACE("%s\n", debugstr_w(ident));
-
     V_VT(&zero) = VT_I2;
     V_I2(&zero) = 0;
-    hres = VarCmp(stack_top(ctx, 0), &zero, ctx->script->lcid, 0);
+    hres = var_cmp(ctx, stack_top(ctx, 0), &zero);
     if(FAILED(hres))
         return hres;
 
     gteq_zero = hres == VARCMP_GT || hres == VARCMP_EQ;
 
-    hres = lookup_identifier(ctx, ident, VBDISP_ANY, &ref);
-    if(FAILED(hres))
-        return hres;
-
-    if(ref.type != REF_VAR) {
-        FIXME("%s is not REF_VAR\n", debugstr_w(ident));
-        return E_FAIL;
-    }
-
-    hres = VarCmp(ref.u.v, stack_top(ctx, 1), ctx->script->lcid, 0);
+    hres = var_cmp(ctx, var, stack_top(ctx, 1));
     if(FAILED(hres))
         return hres;
 
@@ -1460,6 +1574,33 @@ static HRESULT interp_step(exec_ctx_t *ctx)
     return S_OK;
 }
 
+static HRESULT interp_step(exec_ctx_t *ctx)
+{
+    const BSTR ident = ctx->instr->arg2.bstr;
+    ref_t ref;
+    HRESULT hres;
+
+    TRACE("%s\n", debugstr_w(ident));
+
+    hres = lookup_identifier(ctx, ident, VBDISP_ANY, &ref);
+    if(FAILED(hres))
+        return hres;
+
+    if(ref.type != REF_VAR) {
+        FIXME("%s is not REF_VAR\n", debugstr_w(ident));
+        return E_FAIL;
+    }
+
+    return do_step(ctx, ref.u.v);
+}
+
+static HRESULT interp_step_local(exec_ctx_t *ctx)
+{
+    TRACE("%u\n", ctx->instr->arg2.uint);
+
+    return do_step(ctx, local_var(ctx, ctx->instr->arg2.uint));
+}
+
 static HRESULT interp_newenum(exec_ctx_t *ctx)
 {
     variant_val_t v;
@@ -1937,15 +2078,6 @@ static HRESULT interp_imp(exec_ctx_t *ctx)
     return stack_push(ctx, &v);
 }
 
-static HRESULT var_cmp(exec_ctx_t *ctx, VARIANT *l, VARIANT *r)
-{
-    TRACE("%s %s\n", debugstr_variant(l), debugstr_variant(r));
-
-    /* FIXME: Fix comparing string to number */
-
-    return VarCmp(l, r, ctx->script->lcid, 0);
- }
-
 static HRESULT cmp_oper(exec_ctx_t *ctx)
 {
     variant_val_t l, r;
@@ -2191,7 +2323,8 @@ static HRESULT interp_add(exec_ctx_t *ctx)
 
     hres = stack_pop_val(ctx, &l);
     if(SUCCEEDED(hres)) {
-        hres = VarAdd(l.v, r.v, &v);
+        if(!int_add(l.v, r.v, FALSE, &v))
+            hres = VarAdd(l.v, r.v, &v);
         release_val(&l);
     }
     release_val(&r);
@@ -2215,7 +2348,8 @@ static HRESULT interp_sub(exec_ctx_t *ctx)
 
     hres = stack_pop_val(ctx, &l);
     if(SUCCEEDED(hres)) {
-        hres = VarSub(l.v, r.v, &v);
+        if(!int_add(l.v, r.v, TRUE, &v))
+            hres = VarSub(l.v, r.v, &v);
         release_val(&l);
     }
     release_val(&r);
@@ -2363,10 +2497,25 @@ static HRESULT interp_neg(exec_ctx_t *ctx)
     return stack_push(ctx, &v);
 }
 
+static HRESULT do_incc(exec_ctx_t *ctx, VARIANT *var)
+{
+    VARIANT v;
+    HRESULT hres;
+
+    if(!int_add(stack_top(ctx, 0), var, FALSE, &v)) {
+        hres = VarAdd(stack_top(ctx, 0), var, &v);
+        if(FAILED(hres))
+            return hres;
+    }
+
+    VariantClear(var);
+    *var = v;
+    return S_OK;
+}
+
 static HRESULT interp_incc(exec_ctx_t *ctx)
 {
     const BSTR ident = ctx->instr->arg1.bstr;
-    VARIANT v;
     ref_t ref;
     HRESULT hres;
 
@@ -2381,13 +2530,14 @@ static HRESULT interp_incc(exec_ctx_t *ctx)
         return E_FAIL;
     }
 
-    hres = VarAdd(stack_top(ctx, 0), ref.u.v, &v);
-    if(FAILED(hres))
-        return hres;
+    return do_incc(ctx, ref.u.v);
+}
 
-    VariantClear(ref.u.v);
-    *ref.u.v = v;
-    return S_OK;
+static HRESULT interp_incc_local(exec_ctx_t *ctx)
+{
+    TRACE("%u\n", ctx->instr->arg1.uint);
+
+    return do_incc(ctx, local_var(ctx, ctx->instr->arg1.uint));
 }
 
 static HRESULT interp_catch(exec_ctx_t *ctx)
@@ -3070,6 +3070,101 @@ good:
     return x;
 }
 
+/*
+ * Constraints on the first character of a match, derived from the leading
+ * opcode of the program. They let MatchRegExp skip start positions that
+ * can't match without setting up the interpreter for each of them.
+ */
+#define FIRST_ANY       0   /* no constraint */
+#define FIRST_CHARS     1   /* one of first_chars */
+#define FIRST_CLASS     2   /* member of classList[first_class] */
+#define FIRST_BOL       3   /* start of input, or of a line if multiline */
+
+static void
+SetFirstChars(regexp_t *re)
+{
+    jsbytecode *pc = re->program;
+    size_t index;
+
+    re->first_kind = FIRST_ANY;
+
+    /* Capturing parentheses don't consume input, look through them. */
+    while (*pc == REOP_LPAREN)
+        pc = ReadCompactIndex(pc + 1, &index);
+
+    switch (*pc++) {
+      case REOP_BOL:
+        re->first_kind = FIRST_BOL;
+        break;
+      case REOP_FLAT:
+        ReadCompactIndex(pc, &index);
+        re->first_kind = FIRST_CHARS;
+        re->first_chars[0] = re->first_chars[1] = re->source[index];
+        break;
+      case REOP_FLAT1:
+        re->first_kind = FIRST_CHARS;
+        re->first_chars[0] = re->first_chars[1] = *pc;
+        break;
+      case REOP_UCFLAT1:
+        re->first_kind = FIRST_CHARS;
+        re->first_chars[0] = re->first_chars[1] = GET_ARG(pc);
+        break;
+      case REOP_ALTPREREQ:
+        re->first_kind = FIRST_CHARS;
+        re->first_chars[0] = GET_ARG(pc + OFFSET_LEN);
+        re->first_chars[1] = GET_ARG(pc + OFFSET_LEN + ARG_LEN);
+        break;
+      case REOP_CLASS:
+        ReadCompactIndex(pc, &re->first_class);
+        re->first_kind = FIRST_CLASS;
+        break;
+    }
+}
+
+/*
+ * Return the first position at or after cp where a match may start, or NULL
+ * if there is none.
+ */
+static const WCHAR *
+SkipToFirstChar(REGlobalData *gData, const WCHAR *cp)
+{
+    const regexp_t *re = gData->regexp;
+    const WCHAR *end = gData->cpend;
+    const RECharSet *charSet;
+    WCHAR c1, c2, ch;
+
+    switch (re->first_kind) {
+      case FIRST_CHARS:
+        c1 = re->first_chars[0];
+        c2 = re->first_chars[1];
+        while (cp < end && *cp != c1 && *cp != c2)
+            cp++;
+        return cp < end ? cp : NULL;
+      case FIRST_CLASS:
+        charSet = &re->classList[re->first_class];
+        assert(charSet->converted);
+        if (charSet->length == 0)
+            return NULL;
+        for (; cp < end; cp++) {
+            ch = *cp;
+            if (ch <= charSet->length && (charSet->u.bits[ch >> 3] & (1 << (ch & 0x7))))
+                return cp;
+        }
+        return NULL;
+      case FIRST_BOL:
+        if (cp == gData->cpbegin)
+            return cp;
+        if (!(re->flags & REG_MULTILINE))
+            return NULL;
+        for (; cp <= end; cp++) {
+            if (RE_IS_LINE_TERM(cp[-1]))
+                return cp;
+        }
+        return NULL;
+    }
+    return cp;
+}
+
 static match_state_t *MatchRegExp(REGlobalData *gData, match_state_t *x)
 {
     match_state_t *result;
@@ -3082,6 +3177,8 @@ static match_state_t *MatchRegExp(REGlobalData *gData, match_state_t *x)
      * in order to detect end-of-input/line condition.
      */
     for (cp2 = cp; cp2 <= gData->cpend; cp2++) {
+        if (!(gData->regexp->flags & REG_STICKY) && !(cp2 = SkipToFirstChar(gData, cp2)))
+            break;
         gData->skipped = cp2 - cp;
         x->cp = cp2;
         for (j = 0; j < gData->regexp->parenCount; j++)
@@ -3281,6 +3378,7 @@ regexp_t* regexp_new(void *cx, heap_pool_t *pool, const WCHAR *str,
     re->parenCount = state.parenCount;
     re->source = str;
     re->source_len = str_len;
+    SetFirstChars(re);
 
 out:
     heap_pool_clear(mark);
@@ -45,6 +45,7 @@ static int     vcomp_max_threads;
 static int     vcomp_num_threads;
 static int     vcomp_num_procs;
 static BOOL    vcomp_nested_fork = FALSE;
+static unsigned int vcomp_spin_count = 4000;
 
 static RTL_CRITICAL_SECTION vcomp_section;
 static RTL_CRITICAL_SECTION_DEBUG critsect_debug =
@@ -118,6 +119,7 @@ struct vcomp_task_data
     unsigned int            dynamic_iterations;
     int                     dynamic_step;
     unsigned int            dynamic_chunksize;
+    LONG64                  dynamic_state;  /* dynamic loop number << 32 | iterations handed out */
 };
 
 extern void CDECL _vcomp_fork_call_wrapper(void *wrapper, int nargs, void **args);
@@ -898,6 +900,27 @@ void CDECL omp_set_num_threads(int num_threads)
         vcomp_num_threads = num_threads;
 }
 
+/* Spinning only pays off when every thread of the team has a processor to
+ * itself; otherwise it steals time from the threads being waited for. */
+static inline BOOL vcomp_should_spin(struct vcomp_team_data *team_data)
+{
+    return vcomp_spin_count && team_data->num_threads <= vcomp_num_procs;
+}
+
+/* Busy-waits for a bounded time until *value changes from old. The read has
+ * acquire semantics, so that data published before the change is visible. */
+static BOOL vcomp_spin_wait(const unsigned int *value, unsigned int old)
+{
+    unsigned int i;
+
+    for (i = 0; i < vcomp_spin_count; i++)
+    {
+        if (ReadAcquire((const LONG *)value) != old) return TRUE;
+        YieldProcessor();
+    }
+    return FALSE;
+}
+
 void CDECL _vcomp_flush(void)
 {
     TRACE("(): stub\n");
@@ -915,13 +938,21 @@ void CDECL _vcomp_barrier(void)
     EnterCriticalSection(&vcomp_section);
     if (++team_data->barrier_count >= team_data->num_threads)
     {
-        team_data->barrier++;
+        /* pairs with the acquire in vcomp_spin_wait() */
+        WriteRelease((LONG *)&team_data->barrier, team_data->barrier + 1);
         team_data->barrier_count = 0;
         WakeAllConditionVariable(&team_data->cond);
     }
     else
     {
         unsigned int barrier = team_data->barrier;
+
+        if (vcomp_should_spin(team_data))
+        {
+            LeaveCriticalSection(&vcomp_section);
+            if (vcomp_spin_wait(&team_data->barrier, barrier)) return;
+            EnterCriticalSection(&vcomp_section);
+        }
         while (team_data->barrier == barrier)
             SleepConditionVariableCS(&team_data->cond, &vcomp_section, INFINITE);
     }
@@ -1261,6 +1292,15 @@ void CDECL _vcomp_for_static_end(void)
     /* nothing to do here */
 }
 
+static void vcomp_set_dynamic_state(struct vcomp_task_data *task_data, LONG64 state)
+{
+    LONG64 old;
+
+    /* a plain 64-bit store may be split on 32-bit platforms */
+    do old = ReadNoFence64(&task_data->dynamic_state);
+    while (InterlockedCompareExchange64(&task_data->dynamic_state, state, old) != old);
+}
+
 void CDECL _vcomp_for_dynamic_init(unsigned int flags, unsigned int first, unsigned int last,
                                    int step, unsigned int chunksize)
 {
@@ -1321,6 +1361,11 @@ void CDECL _vcomp_for_dynamic_init(unsigned int flags, unsigned int first, unsig
         thread_data->dynamic_type = type;
         if ((int)(thread_data->dynamic - task_data->dynamic) > 0)
         {
+            /* Publish the new loop number before rewriting the parameters.
+             * A thread still claiming chunks of the previous loop may read
+             * the new values, but its compare-and-swap on the old state then
+             * fails and the values are discarded. */
+            vcomp_set_dynamic_state(task_data, (ULONG64)thread_data->dynamic << 32);
             task_data->dynamic              = thread_data->dynamic;
             task_data->dynamic_first        = first;
             task_data->dynamic_last         = last;
@@ -1351,26 +1396,38 @@ int CDECL _vcomp_for_dynamic_next(unsigned int *begin, unsigned int *end)
     else if (thread_data->dynamic_type == VCOMP_DYNAMIC_FLAGS_CHUNKED ||
              thread_data->dynamic_type == VCOMP_DYNAMIC_FLAGS_GUIDED)
     {
-        unsigned int iterations = 0;
-        EnterCriticalSection(&vcomp_section);
-        if (thread_data->dynamic == task_data->dynamic &&
-            task_data->dynamic_iterations != 0)
+        unsigned int iterations, remaining, done;
+        LONG64 state;
+
+        /* Chunks are claimed by advancing the number of iterations handed out
+         * with a compare-and-swap. The loop number in the upper half makes the
+         * swap fail once a thread has moved on to the next loop and reused
+         * task_data, which only happens after all iterations were claimed.
+         * The new loop number is published before the parameters are
+         * rewritten, so a successful swap also validates the values read. */
+        do
         {
-            iterations = min(task_data->dynamic_iterations, task_data->dynamic_chunksize);
+            state = ReadNoFence64(&task_data->dynamic_state);
+            if ((unsigned int)(state >> 32) != thread_data->dynamic) return 0;
+
+            done = (unsigned int)state;
+            remaining = task_data->dynamic_iterations - done;
+            if (!remaining) return 0;
+
+            iterations = min(remaining, task_data->dynamic_chunksize);
             if (thread_data->dynamic_type == VCOMP_DYNAMIC_FLAGS_GUIDED &&
-                task_data->dynamic_iterations > num_threads * task_data->dynamic_chunksize)
+                remaining > num_threads * task_data->dynamic_chunksize)
             {
-                iterations = (task_data->dynamic_iterations + num_threads - 1) / num_threads;
+                iterations = (remaining + num_threads - 1) / num_threads;
             }
-            *begin = task_data->dynamic_first;
-            *end   = task_data->dynamic_first + (iterations - 1) * task_data->dynamic_step;
-            task_data->dynamic_iterations -= iterations;
-            task_data->dynamic_first      += iterations * task_data->dynamic_step;
-            if (!task_data->dynamic_iterations)
+            *begin = task_data->dynamic_first + done * task_data->dynamic_step;
+            *end   = *begin + (iterations - 1) * task_data->dynamic_step;
+            if (iterations == remaining)
                 *end = task_data->dynamic_last;
         }
-        LeaveCriticalSection(&vcomp_section);
-        return iterations != 0;
+        while (InterlockedCompareExchange64(&task_data->dynamic_state, state + iterations, state) != state);
+
+        return 1;
     }
 
     return 0;
@@ -1404,6 +1461,22 @@ static DWORD WINAPI _vcomp_fork_worker(void *param)
             list_add_tail(&vcomp_idle_threads, &thread_data->entry);
             if (++team->finished_threads >= team->num_threads)
                 WakeAllConditionVariable(&team->cond);
+
+            /* consecutive parallel regions usually follow shortly, so stay
+             * around for a moment to be picked up without a wakeup */
+            if (vcomp_should_spin(team))
+            {
+                unsigned int i;
+
+                LeaveCriticalSection(&vcomp_section);
+                for (i = 0; i < vcomp_spin_count; i++)
+                {
+                    if (*(struct vcomp_team_data * volatile *)&thread_data->team) break;
+                    YieldProcessor();
+                }
+                EnterCriticalSection(&vcomp_section);
+                if (thread_data->team) continue;
+            }
         }
 
         if (!SleepConditionVariableCS(&thread_data->cond, &vcomp_section, 5000) &&
@@ -1455,6 +1528,7 @@ void WINAPIV _vcomp_fork(BOOL ifval, int nargs, void *wrapper, ...)
     task_data.single            = 0;
     task_data.section           = 0;
     task_data.dynamic           = 0;
+    task_data.dynamic_state     = 0;
 
     thread_data.team            = &team_data;
     thread_data.task            = &task_data;
@@ -1807,6 +1881,7 @@ BOOL WINAPI DllMain(HINSTANCE instance, DWORD reason, LPVOID reserved)
         case DLL_PROCESS_ATTACH:
         {
             SYSTEM_INFO sysinfo;
+            char buffer[16];
 
             if ((vcomp_context_tls = TlsAlloc()) == TLS_OUT_OF_INDEXES)
             {
@@ -1819,6 +1894,12 @@ BOOL WINAPI DllMain(HINSTANCE instance, DWORD reason, LPVOID reserved)
             vcomp_max_threads = sysinfo.dwNumberOfProcessors;
             vcomp_num_threads = sysinfo.dwNumberOfProcessors;
             vcomp_num_procs   = sysinfo.dwNumberOfProcessors;
+
+            if (GetEnvironmentVariableA("OMP_WAIT_POLICY", buffer, sizeof(buffer)))
+            {
+                if (!stricmp(buffer, "active")) vcomp_spin_count = 1 << 22;
+                else if (!stricmp(buffer, "passive")) vcomp_spin_count = 0;
+            }
             break;
         }
 
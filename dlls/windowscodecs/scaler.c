@@ -40,6 +40,7 @@ typedef struct BitmapScaler {
     UINT src_width, src_height;
     WICBitmapInterpolationMode mode;
     UINT bpp;
+    BOOL straight_alpha;
     void (*fn_get_required_source_rect)(struct BitmapScaler*,UINT,UINT,WICRect*);
     void (*fn_copy_scanline)(struct BitmapScaler*,UINT,UINT,UINT,BYTE**,UINT,UINT,BYTE*);
     CRITICAL_SECTION lock; /* must be held when initialized */
@@ -203,6 +204,145 @@ static void NearestNeighbor_CopyScanline(BitmapScaler *This,
     }
 }
 
+/* Source pixels contributing to one destination pixel along an axis. When
+ * shrinking, Fant averages all the covered source pixels; otherwise the two
+ * nearest source pixels are interpolated linearly, with the weight of the
+ * second one given in 1/256 units. */
+struct scaler_span
+{
+    UINT start, count;
+    BOOL linear;
+    UINT weight;
+};
+
+static void get_source_span(BOOL box, UINT dst, UINT src_size, UINT dst_size, struct scaler_span *span)
+{
+    INT64 pos;
+
+    if (box && src_size > dst_size)
+    {
+        span->start = (UINT64)dst * src_size / dst_size;
+        span->count = ((UINT64)(dst + 1) * src_size + dst_size - 1) / dst_size - span->start;
+        span->linear = FALSE;
+        span->weight = 0;
+        return;
+    }
+
+    /* Position of the destination pixel centre in source pixels, in units of
+     * 1 / (2 * dst_size). */
+    pos = (INT64)(2 * dst + 1) * src_size - dst_size;
+    span->linear = TRUE;
+    if (pos < 0)
+    {
+        span->start = 0;
+        span->weight = 0;
+    }
+    else
+    {
+        span->start = pos / (2 * (INT64)dst_size);
+        span->weight = (pos % (2 * (INT64)dst_size)) * 256 / (2 * (INT64)dst_size);
+    }
+    if (span->start + 1 < src_size)
+    {
+        span->count = 2;
+    }
+    else
+    {
+        span->start = src_size - 1;
+        span->count = 1;
+        span->weight = 0;
+    }
+}
+
+static void Filter_GetRequiredSourceRect(BitmapScaler *This,
+    UINT x, UINT y, WICRect *src_rect)
+{
+    BOOL box = This->mode != WICBitmapInterpolationModeLinear;
+    struct scaler_span span;
+
+    get_source_span(box, x, This->src_width, This->width, &span);
+    src_rect->X = span.start;
+    src_rect->Width = span.count;
+    get_source_span(box, y, This->src_height, This->height, &span);
+    src_rect->Y = span.start;
+    src_rect->Height = span.count;
+}
+
+static inline UINT get_span_weight(const struct scaler_span *span, UINT i)
+{
+    if (!span->linear)
+        return 1;
+    return i ? span->weight : 256 - span->weight;
+}
+
+/* Filters formats with one byte per channel. Colors with straight alpha are
+ * weighted by their alpha, so that transparent pixels don't bleed into the
+ * result. */
+static void Filter_CopyScanline(BitmapScaler *This,
+    UINT dst_x, UINT dst_y, UINT dst_width,
+    BYTE **src_data, UINT src_data_x, UINT src_data_y, BYTE *pbBuffer)
+{
+    BOOL box = This->mode != WICBitmapInterpolationModeLinear;
+    UINT bytesperpixel = This->bpp / 8;
+    struct scaler_span span_x, span_y;
+    UINT64 sum[4], total, weight;
+    UINT i, j, k, c, wx, wy;
+    const BYTE *src;
+
+    get_source_span(box, dst_y, This->src_height, This->height, &span_y);
+
+    for (i = 0; i < dst_width; i++)
+    {
+        get_source_span(box, dst_x + i, This->src_width, This->width, &span_x);
+
+        memset(sum, 0, sizeof(sum));
+        total = 0;
+        for (j = 0; j < span_y.count; j++)
+        {
+            wy = get_span_weight(&span_y, j);
+            for (k = 0; k < span_x.count; k++)
+            {
+                wx = get_span_weight(&span_x, k) * wy;
+                src = src_data[span_y.start + j - src_data_y]
+                        + bytesperpixel * (span_x.start + k - src_data_x);
+                for (c = 0; c < bytesperpixel; c++)
+                {
+                    weight = wx;
+                    if (This->straight_alpha && c < 3)
+                        weight *= src[3];
+                    sum[c] += src[c] * weight;
+                }
+                total += wx;
+            }
+        }
+
+        if (This->straight_alpha)
+        {
+            /* sum[3] is the total weight of the colors */
+            for (c = 0; c < 3; c++)
+                pbBuffer[4 * i + c] = sum[3] ? (sum[c] + sum[3] / 2) / sum[3] : 0;
+            pbBuffer[4 * i + 3] = (sum[3] + total / 2) / total;
+        }
+        else
+        {
+            for (c = 0; c < bytesperpixel; c++)
+                pbBuffer[bytesperpixel * i + c] = (sum[c] + total / 2) / total;
+        }
+    }
+}
+
+static BOOL filter_supports_format(const WICPixelFormatGUID *format)
+{
+    return IsEqualGUID(format, &GUID_WICPixelFormat8bppGray)
+            || IsEqualGUID(format, &GUID_WICPixelFormat24bppBGR)
+            || IsEqualGUID(format, &GUID_WICPixelFormat24bppRGB)
+            || IsEqualGUID(format, &GUID_WICPixelFormat32bppBGR)
+            || IsEqualGUID(format, &GUID_WICPixelFormat32bppBGRA)
+            || IsEqualGUID(format, &GUID_WICPixelFormat32bppPBGRA)
+            || IsEqualGUID(format, &GUID_WICPixelFormat32bppRGBA)
+            || IsEqualGUID(format, &GUID_WICPixelFormat32bppPRGBA);
+}
+
 static HRESULT WINAPI BitmapScaler_CopyPixels(IWICBitmapScaler *iface,
     const WICRect *prc, UINT cbStride, UINT cbBufferSize, BYTE *pbBuffer)
 {
@@ -349,12 +489,46 @@ static HRESULT WINAPI BitmapScaler_Initialize(IWICBitmapScaler *iface,
 
     if (SUCCEEDED(hr))
     {
+        BOOL filter = FALSE;
+
         switch (mode)
         {
-        default:
-            FIXME("unsupported mode %i\n", mode);
+        case WICBitmapInterpolationModeCubic:
+        case WICBitmapInterpolationModeHighQualityCubic:
+            /* Fant is the closest filter we have, it at least averages all
+             * the source pixels when shrinking. */
+            FIXME("Cubic interpolation is not supported, using Fant.\n");
             /* fall-through */
+        case WICBitmapInterpolationModeLinear:
+        case WICBitmapInterpolationModeFant:
+            filter = TRUE;
+            break;
         case WICBitmapInterpolationModeNearestNeighbor:
+            break;
+        default:
+            FIXME("unsupported mode %i\n", mode);
+            break;
+        }
+
+        /* The filter only handles 8-bit channels. Scale other formats with
+         * nearest neighbor so that the output keeps the source format. */
+        if (filter && !filter_supports_format(&src_pixelformat))
+        {
+            FIXME("mode %i not supported for %s, using nearest neighbor\n", mode, debugstr_guid(&src_pixelformat));
+            filter = FALSE;
+        }
+
+        if (filter)
+        {
+            This->straight_alpha = IsEqualGUID(&src_pixelformat, &GUID_WICPixelFormat32bppBGRA)
+                    || IsEqualGUID(&src_pixelformat, &GUID_WICPixelFormat32bppRGBA);
+            IWICBitmapSource_AddRef(pISource);
+            This->source = pISource;
+            This->fn_get_required_source_rect = Filter_GetRequiredSourceRect;
+            This->fn_copy_scanline = Filter_CopyScanline;
+        }
+        else
+        {
             if ((This->bpp % 8) == 0)
             {
                 IWICBitmapSource_AddRef(pISource);
@@ -368,7 +542,6 @@ static HRESULT WINAPI BitmapScaler_Initialize(IWICBitmapScaler *iface,
             }
             This->fn_get_required_source_rect = NearestNeighbor_GetRequiredSourceRect;
             This->fn_copy_scanline = NearestNeighbor_CopyScanline;
-            break;
         }
     }
 
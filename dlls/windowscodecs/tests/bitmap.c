@@ -1318,6 +1318,67 @@ static void test_bitmap_scaler(void)
     IWICBitmap_Release(bitmap);
 }
 
+static void test_bitmap_scaler_fant(void)
+{
+    static const BYTE src[] =
+    {
+        0x10, 0x00, 0x80, 0xff,  0x30, 0x00, 0x80, 0xff,  0x00, 0x40, 0x00, 0xff,  0x00, 0x40, 0x08, 0xff,
+        0x20, 0x00, 0x80, 0xff,  0x40, 0x00, 0x80, 0xff,  0x00, 0x40, 0x10, 0xff,  0x00, 0x40, 0x20, 0xff,
+    };
+    static const BYTE expected[] =
+    {
+        0x28, 0x00, 0x80, 0xff,  0x00, 0x40, 0x0e, 0xff,
+    };
+    IWICBitmapScaler *scaler;
+    WICPixelFormatGUID format;
+    IWICBitmap *bitmap;
+    BYTE buf[8];
+    HRESULT hr;
+
+    hr = IWICImagingFactory_CreateBitmapFromMemory(factory, 4, 2, &GUID_WICPixelFormat32bppBGRA,
+        16, sizeof(src), (BYTE *)src, &bitmap);
+    ok(hr == S_OK, "Failed to create a bitmap, hr %#lx.\n", hr);
+
+    hr = IWICImagingFactory_CreateBitmapScaler(factory, &scaler);
+    ok(hr == S_OK, "Failed to create bitmap scaler, hr %#lx.\n", hr);
+
+    hr = IWICBitmapScaler_Initialize(scaler, (IWICBitmapSource *)bitmap, 2, 1,
+        WICBitmapInterpolationModeFant);
+    ok(hr == S_OK, "Failed to initialize bitmap scaler, hr %#lx.\n", hr);
+
+    memset(buf, 0xcc, sizeof(buf));
+    hr = IWICBitmapScaler_CopyPixels(scaler, NULL, 8, sizeof(buf), buf);
+    ok(hr == S_OK, "Unexpected hr %#lx.\n", hr);
+    ok(!memcmp(buf, expected, sizeof(expected)), "Unexpected data %08lx %08lx.\n",
+        ((DWORD *)buf)[0], ((DWORD *)buf)[1]);
+
+    IWICBitmapScaler_Release(scaler);
+    IWICBitmap_Release(bitmap);
+
+    /* Formats the filter can't handle keep their pixel format. */
+    hr = IWICImagingFactory_CreateBitmap(factory, 4, 2, &GUID_WICPixelFormat64bppRGBA,
+        WICBitmapCacheOnLoad, &bitmap);
+    ok(hr == S_OK, "Failed to create a bitmap, hr %#lx.\n", hr);
+
+    hr = IWICImagingFactory_CreateBitmapScaler(factory, &scaler);
+    ok(hr == S_OK, "Failed to create bitmap scaler, hr %#lx.\n", hr);
+
+    /* HighQualityCubic is not supported before Windows 10. */
+    hr = IWICBitmapScaler_Initialize(scaler, (IWICBitmapSource *)bitmap, 2, 1,
+        WICBitmapInterpolationModeHighQualityCubic);
+    ok(hr == S_OK || broken(hr == E_INVALIDARG), "Failed to initialize bitmap scaler, hr %#lx.\n", hr);
+
+    if (hr == S_OK)
+    {
+        hr = IWICBitmapScaler_GetPixelFormat(scaler, &format);
+        ok(hr == S_OK, "Unexpected hr %#lx.\n", hr);
+        ok(IsEqualGUID(&format, &GUID_WICPixelFormat64bppRGBA), "Unexpected format %s.\n", wine_dbgstr_guid(&format));
+    }
+
+    IWICBitmapScaler_Release(scaler);
+    IWICBitmap_Release(bitmap);
+}
+
 static LONG obj_refcount(void *obj)
 {
     IUnknown_AddRef((IUnknown *)obj);
@@ -1494,6 +1555,7 @@ START_TEST(bitmap)
     test_CreateBitmapFromHBITMAP();
     test_clipper();
     test_bitmap_scaler();
+    test_bitmap_scaler_fant();
 
     IWICImagingFactory_Release(factory);
 
@@ -4069,6 +4069,105 @@ static void wined3d_cs_packet_incref_objects(struct wined3d_cs_packet *packet)
     }
 }
 
+/* A state setter recorded on a deferred context since the last packet that
+ * may observe that state. A later setter of the same kind covering the same
+ * slots makes the earlier one redundant. */
+struct wined3d_deferred_setter
+{
+    struct wined3d_cs_packet *packet;
+    enum wined3d_cs_op opcode;
+    unsigned int type;
+    unsigned int start_idx, count;
+};
+
+static bool wined3d_cs_packet_get_setter(struct wined3d_cs_packet *packet, struct wined3d_deferred_setter *setter)
+{
+    enum wined3d_cs_op opcode = *(const enum wined3d_cs_op *)packet->data;
+
+    setter->packet = packet;
+    setter->opcode = opcode;
+    setter->type = 0;
+    setter->start_idx = 0;
+    setter->count = 1;
+
+    /* Only setters whose execution does nothing but replace the bound state
+     * are listed here. Depth/stencil views may discard their previous
+     * contents, and unordered access views carry an initial counter value,
+     * so neither can be dropped. */
+    switch (opcode)
+    {
+        case WINED3D_CS_OP_SET_PREDICATION:
+        case WINED3D_CS_OP_SET_VERTEX_DECLARATION:
+        case WINED3D_CS_OP_SET_STREAM_OUTPUTS:
+        case WINED3D_CS_OP_SET_INDEX_BUFFER:
+        case WINED3D_CS_OP_SET_BLEND_STATE:
+        case WINED3D_CS_OP_SET_DEPTH_STENCIL_STATE:
+        case WINED3D_CS_OP_SET_RASTERIZER_STATE:
+            return true;
+
+        case WINED3D_CS_OP_SET_VIEWPORTS:
+        case WINED3D_CS_OP_SET_SCISSOR_RECTS:
+            /* These replace the whole array. */
+            setter->count = ~0u;
+            return true;
+
+        case WINED3D_CS_OP_SET_SHADER:
+            setter->type = ((const struct wined3d_cs_set_shader *)packet->data)->type;
+            return true;
+
+        case WINED3D_CS_OP_SET_RENDERTARGET_VIEWS:
+        {
+            const struct wined3d_cs_set_rendertarget_views *op = (const void *)packet->data;
+
+            setter->start_idx = op->start_idx;
+            setter->count = op->count;
+            return true;
+        }
+
+        case WINED3D_CS_OP_SET_STREAM_SOURCES:
+        {
+            const struct wined3d_cs_set_stream_sources *op = (const void *)packet->data;
+
+            setter->start_idx = op->start_idx;
+            setter->count = op->count;
+            return true;
+        }
+
+        case WINED3D_CS_OP_SET_CONSTANT_BUFFERS:
+        {
+            const struct wined3d_cs_set_constant_buffers *op = (const void *)packet->data;
+
+            setter->type = op->type;
+            setter->start_idx = op->start_idx;
+            setter->count = op->count;
+            return true;
+        }
+
+        case WINED3D_CS_OP_SET_SHADER_RESOURCE_VIEWS:
+        {
+            const struct wined3d_cs_set_shader_resource_views *op = (const void *)packet->data;
+
+            setter->type = op->type;
+            setter->start_idx = op->start_idx;
+            setter->count = op->count;
+            return true;
+        }
+
+        case WINED3D_CS_OP_SET_SAMPLERS:
+        {
+            const struct wined3d_cs_set_samplers *op = (const void *)packet->data;
+
+            setter->type = op->type;
+            setter->start_idx = op->start_idx;
+            setter->count = op->count;
+            return true;
+        }
+
+        default:
+            return false;
+    }
+}
+
 struct wined3d_deferred_context
 {
     struct wined3d_device_context c;
@@ -4093,6 +4192,9 @@ struct wined3d_deferred_context
 
     SIZE_T query_count, queries_capacity;
     struct wined3d_deferred_query_issue *queries;
+
+    SIZE_T setters_capacity;
+    struct wined3d_deferred_setter *setters;
 };
 
 static struct wined3d_deferred_context *wined3d_deferred_context_from_context(struct wined3d_device_context *context)
@@ -4417,20 +4519,107 @@ void CDECL wined3d_deferred_context_destroy(struct wined3d_device_context *conte
     }
 
     wined3d_state_destroy(deferred->c.state);
+    free(deferred->setters);
     free(deferred->data);
     free(deferred);
 }
 
+/* Replace state setters that are overridden before anything could observe
+ * them with NOPs, so that the CS thread doesn't have to replay them every
+ * time the command list is executed. */
+static SIZE_T wined3d_deferred_context_elide_setters(struct wined3d_deferred_context *deferred)
+{
+    struct wined3d_deferred_setter setter, *prev;
+    SIZE_T offset = 0, count = 0, elided = 0, i;
+    struct wined3d_cs_packet *packet;
+
+    while (offset < deferred->data_size)
+    {
+        packet = wined3d_next_cs_packet(deferred->data, &offset, ~(SIZE_T)0);
+
+        if (!wined3d_cs_packet_get_setter(packet, &setter))
+        {
+            count = 0;
+            continue;
+        }
+
+        for (i = 0; i < count;)
+        {
+            prev = &deferred->setters[i];
+
+            if (prev->opcode == setter.opcode && prev->type == setter.type
+                    && setter.start_idx <= prev->start_idx
+                    && prev->start_idx + prev->count <= setter.start_idx + setter.count)
+            {
+                wined3d_cs_packet_decref_objects(prev->packet);
+                *(enum wined3d_cs_op *)prev->packet->data = WINED3D_CS_OP_NOP;
+                deferred->setters[i] = deferred->setters[--count];
+                ++elided;
+            }
+            else
+            {
+                ++i;
+            }
+        }
+
+        if (!wined3d_array_reserve((void **)&deferred->setters, &deferred->setters_capacity,
+                count + 1, sizeof(*deferred->setters)))
+        {
+            count = 0;
+            continue;
+        }
+        deferred->setters[count++] = setter;
+    }
+
+    return elided;
+}
+
+static int __cdecl wined3d_resource_ptr_compare(const void *a, const void *b)
+{
+    const struct wined3d_resource *r1 = *(struct wined3d_resource *const *)a;
+    const struct wined3d_resource *r2 = *(struct wined3d_resource *const *)b;
+
+    return r1 < r2 ? -1 : r1 > r2;
+}
+
+/* Resources are referenced once per draw or dispatch that uses them. Drop
+ * the duplicates, since every entry has to be referenced again on each
+ * execution of the command list. */
+static void wined3d_deferred_context_unique_resources(struct wined3d_deferred_context *deferred)
+{
+    SIZE_T i, count = 0;
+
+    if (deferred->resource_count < 2)
+        return;
+
+    qsort(deferred->resources, deferred->resource_count, sizeof(*deferred->resources), wined3d_resource_ptr_compare);
+    for (i = 0; i < deferred->resource_count; ++i)
+    {
+        if (count && deferred->resources[count - 1] == deferred->resources[i])
+            wined3d_resource_decref(deferred->resources[i]);
+        else
+            deferred->resources[count++] = deferred->resources[i];
+    }
+    deferred->resource_count = count;
+}
+
 HRESULT CDECL wined3d_deferred_context_record_command_list(struct wined3d_device_context *context,
         bool restore, struct wined3d_command_list **list)
 {
     struct wined3d_deferred_context *deferred = wined3d_deferred_context_from_context(context);
+    const struct wined3d_cs_packet *packet;
     struct wined3d_command_list *object;
+    SIZE_T offset, size, elided;
     void *memory;
 
     TRACE("context %p, list %p.\n", context, list);
 
     wined3d_device_context_lock(context);
+
+    if ((elided = wined3d_deferred_context_elide_setters(deferred)))
+        TRACE("Elided %Iu redundant state packets.\n", elided);
+    wined3d_deferred_context_unique_resources(deferred);
+
     memory = malloc(sizeof(*object) + deferred->resource_count * sizeof(*object->resources)
             + deferred->upload_count * sizeof(*object->uploads)
             + deferred->command_list_count * sizeof(*object->command_lists)
@@ -4475,8 +4664,17 @@ HRESULT CDECL wined3d_deferred_context_record_command_list(struct wined3d_device
     /* Transfer our references to the queries to the command list. */
 
     object->data = memory;
-    object->data_size = deferred->data_size;
-    memcpy(object->data, deferred->data, deferred->data_size);
+    object->data_size = 0;
+    offset = 0;
+    while (offset < deferred->data_size)
+    {
+        packet = wined3d_next_cs_packet(deferred->data, &offset, ~(SIZE_T)0);
+        if (*(const enum wined3d_cs_op *)packet->data == WINED3D_CS_OP_NOP)
+            continue;
+        size = offsetof(struct wined3d_cs_packet, data[packet->size]);
+        memcpy((BYTE *)object->data + object->data_size, packet, size);
+        object->data_size += size;
+    }
 
     deferred->data_size = 0;
     deferred->resource_count = 0;
@@ -21,6 +21,7 @@
 #include "wined3d_vk.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(d3d_shader);
+WINE_DECLARE_DEBUG_CHANNEL(d3d_perf);
 
 static const struct wined3d_shader_backend_ops spirv_shader_backend_vk;
 
@@ -51,6 +52,11 @@ struct shader_spirv_priv
     const struct wined3d_fragment_pipe_ops *fragment_pipe;
 
     struct shader_spirv_resource_bindings bindings;
+
+    TP_POOL *precompile_pool;
+    TP_CALLBACK_ENVIRON precompile_env;
+    unsigned int precompile_hits, precompile_misses;
+    LONGLONG precompile_stall_time;
 };
 
 #define MAX_SM1_INTER_STAGE_VARYINGS 12
@@ -82,10 +88,26 @@ struct shader_spirv_graphics_program_variant_vk
     VkShaderModule vk_module;
 };
 
+/* A variant speculatively compiled on the precompile thread pool, using the
+ * compile arguments most likely to be used at draw time. */
+struct shader_spirv_precompiled_variant_vk
+{
+    TP_WORK *work;
+    struct wined3d_device_vk *device_vk;
+    const struct wined3d_shader *shader;
+
+    struct shader_spirv_compile_arguments compile_args;
+    struct shader_spirv_resource_bindings bindings;
+
+    VkShaderModule vk_module;
+    LONG complete;
+};
+
 struct shader_spirv_graphics_program_vk
 {
     struct shader_spirv_graphics_program_variant_vk *variants;
     SIZE_T variants_size, variant_count;
+    struct shader_spirv_precompiled_variant_vk *precompiled;
 
     struct vkd3d_shader_scan_descriptor_info descriptor_info;
     struct vkd3d_shader_scan_signature_info signature_info;
@@ -252,12 +274,11 @@ static void shader_spirv_init_shader_interface_vk(struct wined3d_shader_spirv_sh
     iface->vkd3d_interface.uav_counter_count = b->uav_counter_count;
 }
 
-static VkShaderModule shader_spirv_compile_shader(struct wined3d_context_vk *context_vk,
+static VkShaderModule shader_spirv_compile_shader(struct wined3d_device_vk *device_vk,
         const struct wined3d_shader_desc *shader_desc, enum vkd3d_shader_source_type source_type,
         enum wined3d_shader_type shader_type, const struct shader_spirv_compile_arguments *args,
         const struct shader_spirv_resource_bindings *bindings, const struct wined3d_stream_output_desc *so_desc)
 {
-    struct wined3d_device_vk *device_vk = wined3d_device_vk(context_vk->c.device);
     const struct wined3d_vk_info *vk_info = &device_vk->vk_info;
     struct wined3d_shader_spirv_compile_args compile_args;
     struct wined3d_shader_spirv_shader_interface iface;
@@ -323,6 +344,82 @@ static VkShaderModule shader_spirv_compile_shader(struct wined3d_context_vk *con
     return module;
 }
 
+static void shader_spirv_resource_bindings_cleanup(struct shader_spirv_resource_bindings *bindings)
+{
+    free(bindings->vk_bindings);
+    free(bindings->bindings);
+}
+
+static void shader_spirv_init_shader_desc(struct wined3d_shader_desc *shader_desc,
+        const struct wined3d_shader *shader)
+{
+    if (shader->source_type == VKD3D_SHADER_SOURCE_D3D_BYTECODE)
+    {
+        shader_desc->byte_code = shader->function;
+        shader_desc->byte_code_size = shader->functionLength;
+    }
+    else
+    {
+        shader_desc->byte_code = shader->byte_code;
+        shader_desc->byte_code_size = shader->byte_code_size;
+    }
+}
+
+static void shader_spirv_precompiled_variant_free(struct shader_spirv_precompiled_variant_vk *precompiled)
+{
+    CloseThreadpoolWork(precompiled->work);
+    shader_spirv_resource_bindings_cleanup(&precompiled->bindings);
+    free(precompiled);
+}
+
+/* Move a speculatively compiled variant into the program's variant list. If
+ * its compile arguments match the ones requested for this draw and the
+ * compilation is still in progress, wait for it instead of compiling the same
+ * variant a second time. */
+static void shader_spirv_graphics_program_adopt_precompiled(struct shader_spirv_priv *priv,
+        struct shader_spirv_graphics_program_vk *program_vk, const struct shader_spirv_compile_arguments *args,
+        const struct wined3d_stream_output_desc *so_desc, size_t binding_base)
+{
+    struct shader_spirv_precompiled_variant_vk *precompiled = program_vk->precompiled;
+    struct shader_spirv_graphics_program_variant_vk *variant_vk;
+    LARGE_INTEGER start, end;
+    bool match;
+
+    match = !so_desc && !binding_base && !memcmp(&precompiled->compile_args, args, sizeof(*args));
+
+    if (!ReadAcquire(&precompiled->complete))
+    {
+        if (!match)
+            return;
+
+        QueryPerformanceCounter(&start);
+        WaitForThreadpoolWorkCallbacks(precompiled->work, FALSE);
+        QueryPerformanceCounter(&end);
+        priv->precompile_stall_time += end.QuadPart - start.QuadPart;
+    }
+
+    if (match)
+        ++priv->precompile_hits;
+
+    program_vk->precompiled = NULL;
+    if (precompiled->vk_module && wined3d_array_reserve((void **)&program_vk->variants,
+            &program_vk->variants_size, program_vk->variant_count + 1, sizeof(*program_vk->variants)))
+    {
+        variant_vk = &program_vk->variants[program_vk->variant_count++];
+        variant_vk->compile_args = precompiled->compile_args;
+        variant_vk->so_desc = NULL;
+        variant_vk->binding_base = 0;
+        variant_vk->vk_module = precompiled->vk_module;
+    }
+    else if (precompiled->vk_module)
+    {
+        const struct wined3d_vk_info *vk_info = &precompiled->device_vk->vk_info;
+
+        VK_CALL(vkDestroyShaderModule(precompiled->device_vk->vk_device, precompiled->vk_module, NULL));
+    }
+    shader_spirv_precompiled_variant_free(precompiled);
+}
+
 static struct shader_spirv_graphics_program_variant_vk *shader_spirv_find_graphics_program_variant_vk(
         struct shader_spirv_priv *priv, struct wined3d_context_vk *context_vk, struct wined3d_shader *shader,
         const struct wined3d_state *state, const struct shader_spirv_resource_bindings *bindings)
@@ -343,6 +440,9 @@ static struct shader_spirv_graphics_program_variant_vk *shader_spirv_find_graphi
     if (!(program_vk = shader->backend_data))
         return NULL;
 
+    if (program_vk->precompiled)
+        shader_spirv_graphics_program_adopt_precompiled(priv, program_vk, &args, so_desc, binding_base);
+
     variant_count = program_vk->variant_count;
     for (i = 0; i < variant_count; ++i)
     {
@@ -358,21 +458,14 @@ static struct shader_spirv_graphics_program_variant_vk *shader_spirv_find_graphi
 
     variant_vk = &program_vk->variants[variant_count];
     variant_vk->compile_args = args;
+    variant_vk->so_desc = so_desc;
     variant_vk->binding_base = binding_base;
 
-    if (shader->source_type == VKD3D_SHADER_SOURCE_D3D_BYTECODE)
-    {
-        shader_desc.byte_code = shader->function;
-        shader_desc.byte_code_size = shader->functionLength;
-    }
-    else
-    {
-        shader_desc.byte_code = shader->byte_code;
-        shader_desc.byte_code_size = shader->byte_code_size;
-    }
-
-    if (!(variant_vk->vk_module = shader_spirv_compile_shader(context_vk, &shader_desc,
-            shader->source_type, shader_type, &args, bindings, so_desc)))
+    shader_spirv_init_shader_desc(&shader_desc, shader);
+    if (priv->precompile_pool)
+        ++priv->precompile_misses;
+    if (!(variant_vk->vk_module = shader_spirv_compile_shader(wined3d_device_vk(context_vk->c.device),
+            &shader_desc, shader->source_type, shader_type, &args, bindings, so_desc)))
         return NULL;
     ++program_vk->variant_count;
 
@@ -400,7 +493,7 @@ static struct shader_spirv_compute_program_vk *shader_spirv_find_compute_program
     shader_desc.byte_code = shader->byte_code;
     shader_desc.byte_code_size = shader->byte_code_size;
 
-    if (!(program->vk_module = shader_spirv_compile_shader(context_vk, &shader_desc,
+    if (!(program->vk_module = shader_spirv_compile_shader(device_vk, &shader_desc,
             shader->source_type, WINED3D_SHADER_TYPE_COMPUTE, NULL, bindings, NULL)))
         return NULL;
 
@@ -439,12 +532,6 @@ static struct shader_spirv_compute_program_vk *shader_spirv_find_compute_program
     return program;
 }
 
-static void shader_spirv_resource_bindings_cleanup(struct shader_spirv_resource_bindings *bindings)
-{
-    free(bindings->vk_bindings);
-    free(bindings->bindings);
-}
-
 static bool shader_spirv_resource_bindings_add_vk_binding(struct shader_spirv_resource_bindings *bindings,
         VkDescriptorType vk_type, VkShaderStageFlagBits vk_stage, size_t *binding_idx)
 {
@@ -623,20 +710,71 @@ static enum wined3d_data_type wined3d_data_type_from_vkd3d(enum vkd3d_shader_res
     }
 }
 
-static bool shader_spirv_resource_bindings_init(struct shader_spirv_resource_bindings *bindings,
-        struct wined3d_shader_resource_bindings *wined3d_bindings,
-        const struct wined3d_state *state, uint32_t shader_mask)
+static bool shader_spirv_resource_bindings_add_shader(struct shader_spirv_resource_bindings *bindings,
+        struct wined3d_shader_resource_bindings *wined3d_bindings, enum wined3d_shader_type shader_type,
+        const struct vkd3d_shader_scan_descriptor_info *descriptor_info)
 {
-    const struct vkd3d_shader_scan_descriptor_info *descriptor_info;
     enum wined3d_shader_descriptor_type wined3d_type;
     enum vkd3d_shader_visibility shader_visibility;
-    enum wined3d_shader_type shader_type;
     VkDescriptorType vk_descriptor_type;
     VkShaderStageFlagBits vk_stage;
-    struct wined3d_shader *shader;
     size_t binding_idx;
     unsigned int i;
 
+    vk_stage = vk_shader_stage_from_wined3d(shader_type);
+    shader_visibility = vkd3d_shader_visibility_from_wined3d(shader_type);
+
+    for (i = 0; i < descriptor_info->descriptor_count; ++i)
+    {
+        const struct vkd3d_shader_descriptor_info *d = &descriptor_info->descriptors[i];
+        uint32_t flags;
+
+        if (d->register_space)
+        {
+            WARN("Unsupported register space %u.\n", d->register_space);
+            return false;
+        }
+
+        if (d->resource_type == VKD3D_SHADER_RESOURCE_BUFFER)
+            flags = VKD3D_SHADER_BINDING_FLAG_BUFFER;
+        else
+            flags = VKD3D_SHADER_BINDING_FLAG_IMAGE;
+
+        vk_descriptor_type = vk_descriptor_type_from_vkd3d(d->type, d->resource_type);
+        if (!shader_spirv_resource_bindings_add_binding(bindings, d->type, vk_descriptor_type,
+                d->register_index, shader_visibility, vk_stage, flags, &binding_idx))
+            return false;
+
+        wined3d_type = wined3d_descriptor_type_from_vkd3d(d->type);
+        if (wined3d_bindings && !wined3d_shader_resource_bindings_add_binding(wined3d_bindings, shader_type,
+                wined3d_type, d->register_index, wined3d_shader_resource_type_from_vkd3d(d->resource_type),
+                wined3d_data_type_from_vkd3d(d->resource_data_type), binding_idx))
+            return false;
+
+        if (d->type == VKD3D_SHADER_DESCRIPTOR_TYPE_UAV
+                && (d->flags & VKD3D_SHADER_DESCRIPTOR_INFO_FLAG_UAV_COUNTER))
+        {
+            if (!shader_spirv_resource_bindings_add_uav_counter_binding(bindings,
+                    d->register_index, shader_visibility, vk_stage, &binding_idx))
+                return false;
+            if (wined3d_bindings && !wined3d_shader_resource_bindings_add_binding(wined3d_bindings,
+                    shader_type, WINED3D_SHADER_DESCRIPTOR_TYPE_UAV_COUNTER, d->register_index,
+                    WINED3D_SHADER_RESOURCE_BUFFER, WINED3D_DATA_UINT, binding_idx))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+static bool shader_spirv_resource_bindings_init(struct shader_spirv_resource_bindings *bindings,
+        struct wined3d_shader_resource_bindings *wined3d_bindings,
+        const struct wined3d_state *state, uint32_t shader_mask)
+{
+    const struct vkd3d_shader_scan_descriptor_info *descriptor_info;
+    enum wined3d_shader_type shader_type;
+    struct wined3d_shader *shader;
+
     bindings->binding_count = 0;
     bindings->uav_counter_count = 0;
     bindings->vk_binding_count = 0;
@@ -661,48 +799,8 @@ static bool shader_spirv_resource_bindings_init(struct shader_spirv_resource_bin
                 bindings->so_stage = WINED3D_SHADER_TYPE_VERTEX;
         }
 
-        vk_stage = vk_shader_stage_from_wined3d(shader_type);
-        shader_visibility = vkd3d_shader_visibility_from_wined3d(shader_type);
-
-        for (i = 0; i < descriptor_info->descriptor_count; ++i)
-        {
-            const struct vkd3d_shader_descriptor_info *d = &descriptor_info->descriptors[i];
-            uint32_t flags;
-
-            if (d->register_space)
-            {
-                WARN("Unsupported register space %u.\n", d->register_space);
-                return false;
-            }
-
-            if (d->resource_type == VKD3D_SHADER_RESOURCE_BUFFER)
-                flags = VKD3D_SHADER_BINDING_FLAG_BUFFER;
-            else
-                flags = VKD3D_SHADER_BINDING_FLAG_IMAGE;
-
-            vk_descriptor_type = vk_descriptor_type_from_vkd3d(d->type, d->resource_type);
-            if (!shader_spirv_resource_bindings_add_binding(bindings, d->type, vk_descriptor_type,
-                    d->register_index, shader_visibility, vk_stage, flags, &binding_idx))
-                return false;
-
-            wined3d_type = wined3d_descriptor_type_from_vkd3d(d->type);
-            if (!wined3d_shader_resource_bindings_add_binding(wined3d_bindings, shader_type,
-                    wined3d_type, d->register_index, wined3d_shader_resource_type_from_vkd3d(d->resource_type),
-                    wined3d_data_type_from_vkd3d(d->resource_data_type), binding_idx))
-                return false;
-
-            if (d->type == VKD3D_SHADER_DESCRIPTOR_TYPE_UAV
-                    && (d->flags & VKD3D_SHADER_DESCRIPTOR_INFO_FLAG_UAV_COUNTER))
-            {
-                if (!shader_spirv_resource_bindings_add_uav_counter_binding(bindings,
-                        d->register_index, shader_visibility, vk_stage, &binding_idx))
-                    return false;
-                if (!wined3d_shader_resource_bindings_add_binding(wined3d_bindings,
-                        shader_type, WINED3D_SHADER_DESCRIPTOR_TYPE_UAV_COUNTER, d->register_index,
-                        WINED3D_SHADER_RESOURCE_BUFFER, WINED3D_DATA_UINT, binding_idx))
-                    return false;
-            }
-        }
+        if (!shader_spirv_resource_bindings_add_shader(bindings, wined3d_bindings, shader_type, descriptor_info))
+            return false;
     }
 
     return true;
@@ -777,6 +875,63 @@ static void shader_spirv_precompile_compute(struct wined3d_shader *shader)
     shader_spirv_scan_shader(shader, &program_vk->descriptor_info, NULL);
 }
 
+static void CALLBACK shader_spirv_precompile_graphics_cb(TP_CALLBACK_INSTANCE *instance, void *ctx, TP_WORK *work)
+{
+    struct shader_spirv_precompiled_variant_vk *precompiled = ctx;
+    const struct wined3d_shader *shader = precompiled->shader;
+    struct wined3d_shader_desc shader_desc;
+
+    shader_spirv_init_shader_desc(&shader_desc, shader);
+    precompiled->vk_module = shader_spirv_compile_shader(precompiled->device_vk, &shader_desc,
+            shader->source_type, shader->reg_maps.shader_version.type, &precompiled->compile_args,
+            &precompiled->bindings, NULL);
+    WriteRelease(&precompiled->complete, TRUE);
+}
+
+/* Compile the variant of a graphics shader most likely to be requested at
+ * draw time on the precompile thread pool, so that draws don't have to. The
+ * guess assumes no stream output, a single sample, no render target fixups,
+ * and that the shader's bindings start at the beginning of the descriptor set
+ * layout. This always holds for the binding base of pixel shaders; for other
+ * stages it holds whenever the preceding stages don't use any descriptors. */
+static void shader_spirv_precompile_graphics(struct shader_spirv_priv *priv,
+        struct shader_spirv_graphics_program_vk *program_vk, struct wined3d_shader *shader)
+{
+    enum wined3d_shader_type shader_type = shader->reg_maps.shader_version.type;
+    struct shader_spirv_precompiled_variant_vk *precompiled;
+
+    if (!priv->precompile_pool || !shader->function || program_vk->precompiled)
+        return;
+
+    if (!(precompiled = calloc(1, sizeof(*precompiled))))
+        return;
+    precompiled->device_vk = wined3d_device_vk(shader->device);
+    precompiled->shader = shader;
+    precompiled->bindings.so_stage = WINED3D_SHADER_TYPE_GEOMETRY;
+    if (shader_type == WINED3D_SHADER_TYPE_PIXEL)
+        precompiled->compile_args.u.fs.sample_count = 1;
+
+    if (!shader_spirv_resource_bindings_add_shader(&precompiled->bindings,
+            NULL, shader_type, &program_vk->descriptor_info))
+    {
+        shader_spirv_resource_bindings_cleanup(&precompiled->bindings);
+        free(precompiled);
+        return;
+    }
+
+    if (!(precompiled->work = CreateThreadpoolWork(shader_spirv_precompile_graphics_cb,
+            precompiled, &priv->precompile_env)))
+    {
+        ERR("Failed to create precompile work item.\n");
+        shader_spirv_resource_bindings_cleanup(&precompiled->bindings);
+        free(precompiled);
+        return;
+    }
+
+    program_vk->precompiled = precompiled;
+    SubmitThreadpoolWork(precompiled->work);
+}
+
 static void shader_spirv_precompile(void *shader_priv, struct wined3d_shader *shader)
 {
     struct shader_spirv_graphics_program_vk *program_vk;
@@ -797,6 +952,7 @@ static void shader_spirv_precompile(void *shader_priv, struct wined3d_shader *sh
     }
 
     shader_spirv_scan_shader(shader, &program_vk->descriptor_info, &program_vk->signature_info);
+    shader_spirv_precompile_graphics(shader_priv, program_vk, shader);
 }
 
 static void shader_spirv_apply_draw_state(void *shader_priv, struct wined3d_context *context,
@@ -977,6 +1133,7 @@ static void shader_spirv_destroy(struct wined3d_shader *shader)
 {
     struct wined3d_device_vk *device_vk = wined3d_device_vk(shader->device);
     struct shader_spirv_graphics_program_variant_vk *variant_vk;
+    struct shader_spirv_precompiled_variant_vk *precompiled;
     struct wined3d_vk_info *vk_info = &device_vk->vk_info;
     struct shader_spirv_graphics_program_vk *program_vk;
     size_t i;
@@ -991,6 +1148,13 @@ static void shader_spirv_destroy(struct wined3d_shader *shader)
     }
 
     program_vk = shader->backend_data;
+    if ((precompiled = program_vk->precompiled))
+    {
+        WaitForThreadpoolWorkCallbacks(precompiled->work, TRUE);
+        if (precompiled->vk_module)
+            VK_CALL(vkDestroyShaderModule(device_vk->vk_device, precompiled->vk_module, NULL));
+        shader_spirv_precompiled_variant_free(precompiled);
+    }
     for (i = 0; i < program_vk->variant_count; ++i)
     {
         variant_vk = &program_vk->variants[i];
@@ -1005,6 +1169,40 @@ static void shader_spirv_destroy(struct wined3d_shader *shader)
     free(program_vk);
 }
 
+static void shader_spirv_init_precompile_pool(struct shader_spirv_priv *priv)
+{
+    unsigned int thread_count = wined3d_settings.shader_precompile_threads;
+    SYSTEM_INFO system_info;
+
+    priv->precompile_pool = NULL;
+    priv->precompile_hits = 0;
+    priv->precompile_misses = 0;
+    priv->precompile_stall_time = 0;
+
+    /* Leave at least one CPU to the application and the command stream
+     * thread. */
+    if (thread_count == ~0u)
+    {
+        GetSystemInfo(&system_info);
+        thread_count = min(max(system_info.dwNumberOfProcessors, 2) - 1, 4);
+    }
+    if (!thread_count)
+        return;
+
+    if (!(priv->precompile_pool = CreateThreadpool(NULL)))
+    {
+        ERR("Failed to create shader precompile thread pool.\n");
+        return;
+    }
+    SetThreadpoolThreadMaximum(priv->precompile_pool, thread_count);
+
+    memset(&priv->precompile_env, 0, sizeof(priv->precompile_env));
+    priv->precompile_env.Version = 1;
+    priv->precompile_env.Pool = priv->precompile_pool;
+
+    TRACE("Using %u shader precompile threads.\n", thread_count);
+}
+
 static HRESULT shader_spirv_alloc(struct wined3d_device *device,
         const struct wined3d_vertex_pipe_ops *vertex_pipe, const struct wined3d_fragment_pipe_ops *fragment_pipe)
 {
@@ -1032,6 +1230,7 @@ static HRESULT shader_spirv_alloc(struct wined3d_device *device,
     priv->vertex_pipe = vertex_pipe;
     priv->fragment_pipe = fragment_pipe;
     memset(&priv->bindings, 0, sizeof(priv->bindings));
+    shader_spirv_init_precompile_pool(priv);
 
     device->vertex_priv = vertex_priv;
     device->fragment_priv = fragment_priv;
@@ -1043,7 +1242,16 @@ static HRESULT shader_spirv_alloc(struct wined3d_device *device,
 static void shader_spirv_free(struct wined3d_device *device, struct wined3d_context *context)
 {
     struct shader_spirv_priv *priv = device->shader_priv;
+    LARGE_INTEGER freq;
 
+    if (priv->precompile_pool)
+    {
+        QueryPerformanceFrequency(&freq);
+        TRACE_(d3d_perf)("Shader precompilation: %u hits, %u misses, %s us stalled.\n",
+                priv->precompile_hits, priv->precompile_misses,
+                wine_dbgstr_longlong(priv->precompile_stall_time * 1000000 / freq.QuadPart));
+        CloseThreadpool(priv->precompile_pool);
+    }
     shader_spirv_resource_bindings_cleanup(&priv->bindings);
     priv->fragment_pipe->free_private(device, context);
     priv->vertex_pipe->vp_free(device, context);
@@ -1088,7 +1296,7 @@ static uint64_t shader_spirv_compile(struct wined3d_context *context, const stru
         enum wined3d_shader_type shader_type)
 {
     struct shader_spirv_resource_bindings bindings = {0};
-    return (uint64_t)shader_spirv_compile_shader(wined3d_context_vk(context), shader_desc,
+    return (uint64_t)shader_spirv_compile_shader(wined3d_device_vk(context->device), shader_desc,
             VKD3D_SHADER_SOURCE_DXBC_TPF, shader_type, NULL, &bindings, NULL);
 }
 
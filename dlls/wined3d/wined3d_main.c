@@ -129,6 +129,7 @@ struct wined3d_settings wined3d_settings =
     .max_sm_cs = UINT_MAX,
     .renderer = WINED3D_RENDERER_AUTO,
     .shader_backend = WINED3D_SHADER_BACKEND_AUTO,
+    .shader_precompile_threads = ~0u,
 };
 
 enum wined3d_renderer CDECL wined3d_get_renderer(void)
@@ -463,6 +464,9 @@ static BOOL wined3d_dll_init(HINSTANCE hInstDLL)
             TRACE("Forcing all constant buffers to be write-mappable.\n");
             wined3d_settings.cb_access_map_w = TRUE;
         }
+        if (!get_config_key_dword(hkey, appkey, env, "ShaderPrecompileThreads",
+                &wined3d_settings.shader_precompile_threads))
+            TRACE("Limiting shader precompilation to %u threads.\n", wined3d_settings.shader_precompile_threads);
     }
 
     if (appkey) RegCloseKey( appkey );
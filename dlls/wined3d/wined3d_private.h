@@ -486,6 +486,7 @@ struct wined3d_settings
     enum wined3d_renderer renderer;
     enum wined3d_shader_backend shader_backend;
     BOOL cb_access_map_w;
+    unsigned int shader_precompile_threads;
 };
 
 extern struct wined3d_settings wined3d_settings;
@@ -64,6 +64,11 @@ struct wg_transform
     GstCaps *input_caps;
 
     bool draining;
+
+    /* Output statistics, to tell how often zero-copy output fails. */
+    guint64 output_count;
+    guint64 copy_count;
+    guint64 copy_bytes;
 };
 
 static struct wg_transform *get_transform(wg_transform_t trans)
@@ -415,6 +420,10 @@ NTSTATUS wg_transform_destroy(void *args)
     GstSample *sample;
     GstBuffer *buffer;
 
+    GST_INFO("transform %p, copied %"G_GUINT64_FORMAT" of %"G_GUINT64_FORMAT" output samples, "
+            "%"G_GUINT64_FORMAT" bytes", transform, transform->copy_count, transform->output_count,
+            transform->copy_bytes);
+
     while ((buffer = gst_atomic_queue_pop(transform->input_queue)))
         gst_buffer_unref(buffer);
     gst_atomic_queue_unref(transform->input_queue);
@@ -945,8 +954,22 @@ static bool sample_needs_buffer_copy(struct wg_sample *sample, GstBuffer *buffer
     return needs_copy;
 }
 
-static NTSTATUS read_transform_output_video(struct wg_sample *sample, GstBuffer *buffer,
-        const GstVideoInfo *src_video_info, const GstVideoInfo *dst_video_info)
+static bool video_info_layout_equal(const GstVideoInfo *a, const GstVideoInfo *b)
+{
+    guint i;
+
+    if (a->size != b->size || GST_VIDEO_INFO_N_PLANES(a) != GST_VIDEO_INFO_N_PLANES(b))
+        return false;
+    for (i = 0; i < GST_VIDEO_INFO_N_PLANES(a); ++i)
+    {
+        if (a->offset[i] != b->offset[i] || a->stride[i] != b->stride[i])
+            return false;
+    }
+    return true;
+}
+
+static NTSTATUS read_transform_output_video(struct wg_transform *transform, struct wg_sample *sample,
+        GstBuffer *buffer, const GstVideoInfo *src_video_info, const GstVideoInfo *dst_video_info)
 {
     gsize total_size;
     NTSTATUS status;
@@ -954,6 +977,11 @@ static NTSTATUS read_transform_output_video(struct wg_sample *sample, GstBuffer
 
     if (!(needs_copy = sample_needs_buffer_copy(sample, buffer, &total_size)))
         status = STATUS_SUCCESS;
+    else if (video_info_layout_equal(src_video_info, dst_video_info)
+            && gst_buffer_get_size(buffer) == dst_video_info->size
+            && sample->max_size >= dst_video_info->size)
+        /* Same planes layout, copy the whole frame at once instead of line by line. */
+        status = copy_buffer(buffer, sample, &total_size);
     else
         status = copy_video_buffer(buffer, src_video_info, dst_video_info, sample, &total_size);
 
@@ -966,8 +994,13 @@ static NTSTATUS read_transform_output_video(struct wg_sample *sample, GstBuffer
 
     set_sample_flags_from_buffer(sample, buffer, total_size);
 
+    transform->output_count++;
     if (needs_copy)
+    {
+        transform->copy_count++;
+        transform->copy_bytes += sample->size;
         GST_WARNING("Copied %u bytes, sample %p, flags %#x", sample->size, sample, sample->flags);
+    }
     else if (sample->flags & WG_SAMPLE_FLAG_INCOMPLETE)
         GST_ERROR("Partial read %u bytes, sample %p, flags %#x", sample->size, sample, sample->flags);
     else
@@ -976,7 +1009,7 @@ static NTSTATUS read_transform_output_video(struct wg_sample *sample, GstBuffer
     return STATUS_SUCCESS;
 }
 
-static NTSTATUS read_transform_output(struct wg_sample *sample, GstBuffer *buffer)
+static NTSTATUS read_transform_output(struct wg_transform *transform, struct wg_sample *sample, GstBuffer *buffer)
 {
     gsize total_size;
     NTSTATUS status;
@@ -996,8 +1029,13 @@ static NTSTATUS read_transform_output(struct wg_sample *sample, GstBuffer *buffe
 
     set_sample_flags_from_buffer(sample, buffer, total_size);
 
+    transform->output_count++;
     if (needs_copy)
+    {
+        transform->copy_count++;
+        transform->copy_bytes += sample->size;
         GST_INFO("Copied %u bytes, sample %p, flags %#x", sample->size, sample, sample->flags);
+    }
     else if (sample->flags & WG_SAMPLE_FLAG_INCOMPLETE)
         GST_ERROR("Partial read %u bytes, sample %p, flags %#x", sample->size, sample, sample->flags);
     else
@@ -1111,10 +1149,10 @@ NTSTATUS wg_transform_read_data(void *args)
     }
 
     if (!strcmp(output_mime, "video/x-raw"))
-        status = read_transform_output_video(sample, output_buffer,
+        status = read_transform_output_video(transform, sample, output_buffer,
                 &src_video_info, &dst_video_info);
     else
-        status = read_transform_output(sample, output_buffer);
+        status = read_transform_output(transform, sample, output_buffer);
 
     if (status)
     {
@@ -75,11 +75,12 @@ struct pulse_stream
     BOOL started;
     SIZE_T bufsize_frames, real_bufsize_bytes, period_bytes;
     SIZE_T peek_ofs, read_offs_bytes, lcl_offs_bytes, pa_offs_bytes;
-    SIZE_T tmp_buffer_bytes, held_bytes, peek_len, peek_buffer_len, pa_held_bytes;
-    BYTE *local_buffer, *tmp_buffer, *peek_buffer;
+    SIZE_T held_bytes, peek_len, peek_buffer_len, pa_held_bytes;
+    BYTE *local_buffer, *peek_buffer;
     void *locked_ptr;
-    BOOL please_quit, just_started, just_underran;
-    pa_usec_t mmdev_period_usec;
+    BOOL please_quit, just_started, just_underran, grow_tlength;
+    UINT32 underruns, base_tlength;
+    pa_usec_t mmdev_period_usec, quiet_usec;
 
     INT64 clock_lastpos, clock_written;
 
@@ -360,9 +361,11 @@ static void pulse_stream_state(pa_stream *s, void *user)
 }
 
 static void pulse_attr_update(pa_stream *s, void *user) {
+    struct pulse_stream *stream = user;
     const pa_buffer_attr *attr = pa_stream_get_buffer_attr(s);
     TRACE("New attributes or device moved:\n");
     dump_attr(attr);
+    stream->attr = *attr;
 }
 
 static void pulse_underflow_callback(pa_stream *s, void *userdata)
@@ -370,6 +373,13 @@ static void pulse_underflow_callback(pa_stream *s, void *userdata)
     struct pulse_stream *stream = userdata;
     WARN("%p: Underflow\n", userdata);
     stream->just_underran = TRUE;
+    /* Underflows while the client has nothing queued are caused by the client
+     * itself, a longer target length wouldn't help. */
+    if (stream->held_bytes)
+    {
+        stream->underruns++;
+        stream->grow_tlength = TRUE;
+    }
 }
 
 static void pulse_started_callback(pa_stream *s, void *userdata)
@@ -1178,11 +1188,14 @@ static NTSTATUS pulse_create_stream(void *args)
         SIZE_T size;
 
         stream->attr = *attr;
+        stream->base_tlength = attr->tlength;
         /* Update frames according to new size */
         dump_attr(attr);
         if (stream->dataflow == eRender) {
-            size = stream->real_bufsize_bytes =
-                stream->bufsize_frames * 2 * pa_frame_size(&stream->ss);
+            stream->real_bufsize_bytes = stream->bufsize_frames * 2 * pa_frame_size(&stream->ss);
+            /* Leave room past the end of the ring for a full-sized GetBuffer
+             * request, so that a wrapping request can be handed out in place. */
+            size = stream->real_bufsize_bytes + bufsize_bytes;
             if (NtAllocateVirtualMemory(GetCurrentProcess(), (void **)&stream->local_buffer,
                                         zero_bits, &size, MEM_COMMIT, PAGE_READWRITE))
                 hr = E_OUTOFMEMORY;
@@ -1253,11 +1266,9 @@ static NTSTATUS pulse_release_stream(void *args)
     pa_stream_unref(stream->stream);
     pulse_unlock();
 
-    if (stream->tmp_buffer) {
-        size = 0;
-        NtFreeVirtualMemory(GetCurrentProcess(), (void **)&stream->tmp_buffer,
-                            &size, MEM_RELEASE);
-    }
+    if (stream->dataflow == eRender)
+        TRACE("%p: %u underruns, target length %u bytes\n", stream, stream->underruns, stream->attr.tlength);
+
     if (stream->local_buffer) {
         size = 0;
         NtFreeVirtualMemory(GetCurrentProcess(), (void **)&stream->local_buffer,
@@ -1407,6 +1418,47 @@ write:
     return pa_stream_write(stream->stream, buffer, bytes, NULL, 0, PA_SEEK_RELATIVE);
 }
 
+/* Each underrun with data queued raises the server-side target length by a
+ * period, up to the maximum length. After TLENGTH_DECAY_USEC without such
+ * underruns it is lowered again by a period, down to the initial value, so
+ * that the latency follows what the stream currently needs. */
+#define TLENGTH_DECAY_USEC 5000000
+
+static void pulse_adapt_tlength(struct pulse_stream *stream)
+{
+    pa_buffer_attr attr = stream->attr;
+    pa_operation *o;
+
+    if (stream->grow_tlength)
+    {
+        stream->grow_tlength = FALSE;
+        stream->quiet_usec = 0;
+        if (attr.tlength + stream->period_bytes > attr.maxlength)
+            return;
+        attr.tlength += stream->period_bytes;
+    }
+    else
+    {
+        if (attr.tlength <= stream->base_tlength)
+            return;
+        stream->quiet_usec += stream->mmdev_period_usec;
+        if (stream->quiet_usec < TLENGTH_DECAY_USEC)
+            return;
+        stream->quiet_usec = 0;
+        if (attr.tlength > stream->base_tlength + stream->period_bytes)
+            attr.tlength -= stream->period_bytes;
+        else
+            attr.tlength = stream->base_tlength;
+    }
+
+    TRACE("%p: %u underruns, setting target length to %u bytes\n", stream, stream->underruns, attr.tlength);
+    if ((o = pa_stream_set_buffer_attr(stream->stream, &attr, NULL, NULL)))
+    {
+        pa_operation_unref(o);
+        stream->attr = attr;
+    }
+}
+
 static void pulse_write(struct pulse_stream *stream)
 {
     /* write as much data to PA as we can */
@@ -1621,6 +1673,7 @@ static NTSTATUS pulse_timer_loop(void *args)
                 if (stream->dataflow == eRender)
                 {
                     pulse_write(stream);
+                    pulse_adapt_tlength(stream);
 
                     /* regardless of what PA does, advance one period */
                     adv_bytes = min(stream->period_bytes, stream->held_bytes);
@@ -1796,29 +1849,6 @@ static NTSTATUS pulse_reset(void *args)
     return STATUS_SUCCESS;
 }
 
-static BOOL alloc_tmp_buffer(struct pulse_stream *stream, SIZE_T bytes)
-{
-    SIZE_T size;
-
-    if (stream->tmp_buffer_bytes >= bytes)
-        return TRUE;
-
-    if (stream->tmp_buffer)
-    {
-        size = 0;
-        NtFreeVirtualMemory(GetCurrentProcess(), (void **)&stream->tmp_buffer,
-                            &size, MEM_RELEASE);
-        stream->tmp_buffer = NULL;
-        stream->tmp_buffer_bytes = 0;
-    }
-    if (NtAllocateVirtualMemory(GetCurrentProcess(), (void **)&stream->tmp_buffer,
-                                zero_bits, &bytes, MEM_COMMIT, PAGE_READWRITE))
-        return FALSE;
-
-    stream->tmp_buffer_bytes = bytes;
-    return TRUE;
-}
-
 static UINT32 pulse_render_padding(struct pulse_stream *stream)
 {
     return stream->held_bytes / pa_frame_size(&stream->ss);
@@ -1875,22 +1905,8 @@ static NTSTATUS pulse_get_render_buffer(void *args)
 
     bytes = params->frames * pa_frame_size(&stream->ss);
     wri_offs_bytes = (stream->lcl_offs_bytes + stream->held_bytes) % stream->real_bufsize_bytes;
-    if (wri_offs_bytes + bytes > stream->real_bufsize_bytes)
-    {
-        if (!alloc_tmp_buffer(stream, bytes))
-        {
-            pulse_unlock();
-            params->result = E_OUTOFMEMORY;
-            return STATUS_SUCCESS;
-        }
-        *params->data = stream->tmp_buffer;
-        stream->locked = -bytes;
-    }
-    else
-    {
-        *params->data = stream->local_buffer + wri_offs_bytes;
-        stream->locked = bytes;
-    }
+    *params->data = stream->local_buffer + wri_offs_bytes;
+    stream->locked = bytes;
 
     silence_buffer(stream->ss.format, *params->data, bytes);
 
@@ -1899,28 +1915,19 @@ static NTSTATUS pulse_get_render_buffer(void *args)
     return STATUS_SUCCESS;
 }
 
-static void pulse_wrap_buffer(struct pulse_stream *stream, BYTE *buffer, UINT32 written_bytes)
+/* Move the part of a released buffer that went past the end of the ring to its start. */
+static void pulse_wrap_buffer(struct pulse_stream *stream, UINT32 wri_offs_bytes, UINT32 written_bytes)
 {
-    UINT32 wri_offs_bytes = (stream->lcl_offs_bytes + stream->held_bytes) % stream->real_bufsize_bytes;
-    UINT32 chunk_bytes = stream->real_bufsize_bytes - wri_offs_bytes;
-
-    if (written_bytes <= chunk_bytes)
-    {
-        memcpy(stream->local_buffer + wri_offs_bytes, buffer, written_bytes);
-    }
-    else
-    {
-        memcpy(stream->local_buffer + wri_offs_bytes, buffer, chunk_bytes);
-        memcpy(stream->local_buffer, buffer + chunk_bytes, written_bytes - chunk_bytes);
-    }
+    if (wri_offs_bytes + written_bytes > stream->real_bufsize_bytes)
+        memcpy(stream->local_buffer, stream->local_buffer + stream->real_bufsize_bytes,
+               wri_offs_bytes + written_bytes - stream->real_bufsize_bytes);
 }
 
 static NTSTATUS pulse_release_render_buffer(void *args)
 {
     struct release_render_buffer_params *params = args;
     struct pulse_stream *stream = handle_get_stream(params->stream);
-    UINT32 written_bytes;
-    BYTE *buffer;
+    UINT32 written_bytes, wri_offs_bytes;
 
     pulse_lock();
     if (!stream->locked || !params->written_frames)
@@ -1931,25 +1938,19 @@ static NTSTATUS pulse_release_render_buffer(void *args)
         return STATUS_SUCCESS;
     }
 
-    if (params->written_frames * pa_frame_size(&stream->ss) >
-        (stream->locked >= 0 ? stream->locked : -stream->locked))
+    if (params->written_frames * pa_frame_size(&stream->ss) > stream->locked)
     {
         pulse_unlock();
         params->result = AUDCLNT_E_INVALID_SIZE;
         return STATUS_SUCCESS;
     }
 
-    if (stream->locked >= 0)
-        buffer = stream->local_buffer + (stream->lcl_offs_bytes + stream->held_bytes) % stream->real_bufsize_bytes;
-    else
-        buffer = stream->tmp_buffer;
-
+    wri_offs_bytes = (stream->lcl_offs_bytes + stream->held_bytes) % stream->real_bufsize_bytes;
     written_bytes = params->written_frames * pa_frame_size(&stream->ss);
     if (params->flags & AUDCLNT_BUFFERFLAGS_SILENT)
-        silence_buffer(stream->ss.format, buffer, written_bytes);
+        silence_buffer(stream->ss.format, stream->local_buffer + wri_offs_bytes, written_bytes);
 
-    if (stream->locked < 0)
-        pulse_wrap_buffer(stream, buffer, written_bytes);
+    pulse_wrap_buffer(stream, wri_offs_bytes, written_bytes);
 
     stream->held_bytes += written_bytes;
     stream->pa_held_bytes += written_bytes;
@@ -2511,7 +2512,8 @@ static NTSTATUS pulse_set_sample_rate(void *args)
     new_ss = stream->ss;
     new_ss.rate = params->rate;
     new_bufsize_frames = ceil((stream->duration / 10000000.) * new_ss.rate);
-    size = new_bufsize_frames * 2 * pa_frame_size(&stream->ss);
+    /* twice the buffer size for the ring, plus room for a wrapping GetBuffer request */
+    size = new_bufsize_frames * 3 * pa_frame_size(&stream->ss);
 
     if (NtAllocateVirtualMemory(GetCurrentProcess(), (void **)&new_buffer,
                                 zero_bits, &size, MEM_COMMIT, PAGE_READWRITE)) {
@@ -2536,7 +2538,7 @@ static NTSTATUS pulse_set_sample_rate(void *args)
     stream->pa_offs_bytes = stream->lcl_offs_bytes = 0;
     stream->held_bytes = stream->pa_held_bytes = 0;
     stream->period_bytes = pa_frame_size(&new_ss) * muldiv(stream->mmdev_period_usec, new_ss.rate, 1000000);
-    stream->real_bufsize_bytes = size;
+    stream->real_bufsize_bytes = new_bufsize_frames * 2 * pa_frame_size(&new_ss);
     stream->bufsize_frames = new_bufsize_frames;
     stream->ss = new_ss;
 
@@ -1373,6 +1373,7 @@ int is_interpreted_func( const type_t *iface, const var_t *func )
     }
     if ((str = get_attrp( func->attrs, ATTR_OPTIMIZE ))) return !strcmp( str, "i" );
     if ((str = get_attrp( iface->attrs, ATTR_OPTIMIZE ))) return !strcmp( str, "i" );
+    if (strarray_exists( &inline_stub_ifaces, iface->name )) return 0;
     return interpreted_mode;
 }
 
@@ -4340,6 +4341,47 @@ void print_phase_basetype(FILE *file, int indent, const char *local_var_prefix,
     }
 }
 
+/* simple structs have the same layout in memory and on the wire, so a
+ * reference to one can be copied directly instead of going through the
+ * NdrSimpleStruct functions */
+static void print_phase_simple_struct(FILE *file, int indent, const char *local_var_prefix,
+                                      enum remoting_phase phase, enum pass pass,
+                                      const var_t *var, const type_t *type)
+{
+    unsigned int size = type_memsize(type);
+    unsigned int alignment = type_buffer_alignment(type);
+
+    if (phase == PHASE_MARSHAL && alignment > 1)
+        print_file(file, indent, "MIDL_memset(__frame->_StubMsg.Buffer, 0, (0x%x - (ULONG_PTR)__frame->_StubMsg.Buffer) & 0x%x);\n", alignment, alignment - 1);
+    print_file(file, indent, "__frame->_StubMsg.Buffer = (unsigned char *)(((ULONG_PTR)__frame->_StubMsg.Buffer + %u) & ~0x%x);\n",
+               alignment - 1, alignment - 1);
+
+    if (phase == PHASE_MARSHAL)
+    {
+        print_file(file, indent, "memcpy(__frame->_StubMsg.Buffer, %s%s, 0x%x);\n",
+                   local_var_prefix, var->name, size);
+    }
+    else
+    {
+        print_file(file, indent, "if (__frame->_StubMsg.Buffer + 0x%x > __frame->_StubMsg.BufferEnd)\n", size);
+        print_file(file, indent, "{\n");
+        print_file(file, indent + 1, "RpcRaiseException(RPC_X_BAD_STUB_DATA);\n");
+        print_file(file, indent, "}\n");
+        if (pass == PASS_IN)
+        {
+            /* servers point straight into the buffer */
+            print_file(file, indent, "%s%s = (", local_var_prefix, var->name);
+            write_type_decl(file, &var->declspec, NULL);
+            fprintf(file, ")__frame->_StubMsg.Buffer;\n");
+        }
+        else
+            print_file(file, indent, "memcpy((void *)%s%s, __frame->_StubMsg.Buffer, 0x%x);\n",
+                       local_var_prefix, var->name, size);
+    }
+
+    print_file(file, indent, "__frame->_StubMsg.Buffer += 0x%x;\n", size);
+}
+
 /* returns whether the MaxCount, Offset or ActualCount members need to be
  * filled in for the specified phase */
 static inline int is_conformance_needed_for_phase(enum remoting_phase phase)
@@ -4708,7 +4750,9 @@ static void write_remoting_arg(FILE *file, int indent, const var_t *func, const
                 /* simple structs have known sizes, so don't need a sizing
                  * pass and don't have any memory to free and so don't
                  * need a freeing pass */
-                if (phase == PHASE_MARSHAL || phase == PHASE_UNMARSHAL)
+                if ((phase == PHASE_MARSHAL || phase == PHASE_UNMARSHAL) && pass != PASS_RETURN)
+                    print_phase_simple_struct(file, indent, local_var_prefix, phase, pass, var, ref);
+                else if (phase == PHASE_MARSHAL || phase == PHASE_UNMARSHAL)
                     type_str = "SimpleStruct";
                 else if (phase == PHASE_FREE && pass == PASS_RETURN)
                 {
@@ -52,6 +52,7 @@ static const char usage[] =
 "   -h                 Generate headers\n"
 "   -H file            Name of header file (default is infile.h)\n"
 "   -I directory       Add directory to the include search path (multiple -I allowed)\n"
+"   --inline-stubs=name Generate inline stubs for interface 'name' (multiple allowed)\n"
 "   -L directory       Add directory to the library search path (multiple -L allowed)\n"
 "   --local-stubs=file Write empty stubs for call_as/local methods to file\n"
 "   -m32, -m64         Set the target architecture (Win32 or Win64)\n"
@@ -110,6 +111,7 @@ int old_names = 0;
 int old_typelib = 0;
 int winrt_mode = 0;
 int interpreted_mode = 1;
+struct strarray inline_stub_ifaces = { 0 };
 int use_abi_namespace = 0;
 static int stdinc = 1;
 
@@ -154,6 +156,7 @@ enum {
     APP_CONFIG_OPTION,
     DLLDATA_OPTION,
     DLLDATA_ONLY_OPTION,
+    INLINE_STUBS_OPTION,
     LOCAL_STUBS_OPTION,
     NOSTDINC_OPTION,
     OLD_TYPELIB_OPTION,
@@ -179,6 +182,7 @@ static const struct long_option long_options[] = {
     { "dlldata", 1, DLLDATA_OPTION },
     { "dlldata-only", 0, DLLDATA_ONLY_OPTION },
     { "help", 0, PRINT_HELP },
+    { "inline-stubs", 1, INLINE_STUBS_OPTION },
     { "local-stubs", 1, LOCAL_STUBS_OPTION },
     { "nostdinc", 0, NOSTDINC_OPTION },
     { "ns_prefix", 0, RT_NS_PREFIX },
@@ -481,6 +485,9 @@ static void option_callback( int optc, char *optarg )
       do_everything = 0;
       do_dlldata = 1;
       break;
+    case INLINE_STUBS_OPTION:
+      strarray_add(&inline_stub_ifaces, xstrdup(optarg));
+      break;
     case LOCAL_STUBS_OPTION:
       do_everything = 0;
       local_stubs_name = xstrdup(optarg);
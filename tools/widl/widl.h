@@ -49,6 +49,7 @@ extern int old_names;
 extern int old_typelib;
 extern int winrt_mode;
 extern int interpreted_mode;
+extern struct strarray inline_stub_ifaces;
 extern int use_abi_namespace;
 
 extern char *input_name;